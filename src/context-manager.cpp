@@ -5,21 +5,36 @@ ContextManager::ContextManager() : bit_context_(1), long_bit_context_(1),
     auxiliary_context_(0), history_(100000000, 0), shared_map_(256*8000000, 0),
     words_(8, 0), recent_bytes_(8, 0) {}
 
-const Context& ContextManager::AddContext(std::unique_ptr<Context> context) {
-  for (const auto& old : contexts_) {
-    if (old->IsEqual(context.get())) return *old;
-  }
-  contexts_.push_back(std::move(context));
-  return *(contexts_[contexts_.size() - 1]);
+const ContextHash& ContextManager::AddContext(ContextHash&& context) {
+  return context_hashes_.Add(std::move(context));
 }
 
-const BitContext& ContextManager::AddBitContext(std::unique_ptr<BitContext>
-    bit_context) {
-  for (const auto& old : bit_contexts_) {
-    if (old->IsEqual(bit_context.get())) return *old;
-  }
-  bit_contexts_.push_back(std::move(bit_context));
-  return *(bit_contexts_[bit_contexts_.size() - 1]);
+const IndirectHash& ContextManager::AddContext(IndirectHash&& context) {
+  return indirect_hashes_.Add(std::move(context));
+}
+
+const Sparse& ContextManager::AddContext(Sparse&& context) {
+  return sparse_contexts_.Add(std::move(context));
+}
+
+const Interval& ContextManager::AddContext(Interval&& context) {
+  return intervals_.Add(std::move(context));
+}
+
+const IntervalHash& ContextManager::AddContext(IntervalHash&& context) {
+  return interval_hashes_.Add(std::move(context));
+}
+
+const BracketContext& ContextManager::AddContext(BracketContext&& context) {
+  return bracket_contexts_.Add(std::move(context));
+}
+
+const CombinedContext& ContextManager::AddContext(CombinedContext&& context) {
+  return combined_contexts_.Add(std::move(context));
+}
+
+const BitContext& ContextManager::AddBitContext(BitContext&& bit_context) {
+  return bit_contexts_.Add(std::move(bit_context));
 }
 
 void ContextManager::UpdateHistory() {
@@ -73,11 +88,13 @@ void ContextManager::UpdateContexts(int bit) {
     UpdateHistory();
     UpdateWords();
     UpdateRecentBytes();
-    for (const auto& context : contexts_) {
-      context->Update();
-    }
-  }
-  for (const auto& context : bit_contexts_) {
-    context->Update();
+    context_hashes_.Update();
+    indirect_hashes_.Update();
+    sparse_contexts_.Update();
+    intervals_.Update();
+    interval_hashes_.Update();
+    bracket_contexts_.Update();
+    combined_contexts_.Update();
   }
+  bit_contexts_.Update();
 }
@@ -3,16 +3,30 @@
 
 #include "states/nonstationary.h"
 #include "states/run-map.h"
-#include "contexts/context.h"
+#include "contexts/context-array.h"
+#include "contexts/context-hash.h"
+#include "contexts/indirect-hash.h"
+#include "contexts/sparse.h"
+#include "contexts/interval.h"
+#include "contexts/interval-hash.h"
+#include "contexts/bracket-context.h"
+#include "contexts/combined-context.h"
 #include "contexts/bit-context.h"
 
 #include <vector>
-#include <memory>
 
 struct ContextManager {
   ContextManager();
-  const Context& AddContext(std::unique_ptr<Context> context);
-  const BitContext& AddBitContext(std::unique_ptr<BitContext> bit_context);
+  // Each returns an existing equal context if there is one. The reference
+  // stays valid for the lifetime of the manager.
+  const ContextHash& AddContext(ContextHash&& context);
+  const IndirectHash& AddContext(IndirectHash&& context);
+  const Sparse& AddContext(Sparse&& context);
+  const Interval& AddContext(Interval&& context);
+  const IntervalHash& AddContext(IntervalHash&& context);
+  const BracketContext& AddContext(BracketContext&& context);
+  const CombinedContext& AddContext(CombinedContext&& context);
+  const BitContext& AddBitContext(BitContext&& bit_context);
   void UpdateContexts(int bit);
   void UpdateHistory();
   void UpdateWords();
@@ -23,8 +37,16 @@ struct ContextManager {
       line_break_, longest_match_, auxiliary_context_;
   std::vector<unsigned char> history_, shared_map_;
   std::vector<unsigned long long> words_, recent_bytes_;
-  std::vector<std::unique_ptr<Context>> contexts_;
-  std::vector<std::unique_ptr<BitContext>> bit_contexts_;
+  // Byte contexts only read the fields above, so the order of the types does
+  // not matter. Bit contexts read byte contexts and are updated every bit.
+  ContextArray<ContextHash> context_hashes_;
+  ContextArray<IndirectHash> indirect_hashes_;
+  ContextArray<Sparse> sparse_contexts_;
+  ContextArray<Interval> intervals_;
+  ContextArray<IntervalHash> interval_hashes_;
+  ContextArray<BracketContext> bracket_contexts_;
+  ContextArray<CombinedContext> combined_contexts_;
+  ContextArray<BitContext> bit_contexts_;
   RunMap run_map_;
   Nonstationary nonstationary_;
 };
@@ -12,10 +12,8 @@ void BitContext::Update() {
   context_ = (byte_context_<<8) + bit_context_;
 }
 
-bool BitContext::IsEqual(Context* c) {
-  BitContext* p = dynamic_cast<BitContext*>(c);
-  if (!p) return false;
-  if (&(p->byte_context_) != &byte_context_) return false;
-  if (&(p->bit_context_) != &bit_context_) return false;
+bool BitContext::IsEqual(const BitContext& c) const {
+  if (&(c.byte_context_) != &byte_context_) return false;
+  if (&(c.bit_context_) != &bit_context_) return false;
   return true;
 }
@@ -8,7 +8,7 @@ class BitContext : public Context {
   BitContext(const unsigned long long& bit_context, const unsigned long long&
       byte_context, unsigned long long byte_context_size);
   void Update();
-  bool IsEqual(Context* c);
+  bool IsEqual(const BitContext& c) const;
 
  private:
   const unsigned long long& bit_context_;
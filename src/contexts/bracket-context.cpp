@@ -2,42 +2,31 @@
 
 BracketContext::BracketContext(const unsigned int& bit_context,
     int distance_limit, int stack_limit) : byte_(bit_context),
-    distance_limit_(distance_limit), stack_limit_(stack_limit) {
-  brackets_ = {{'(',')'}, {'{','}'}, {'[',']'}, {'<','>'}};
+    distance_limit_(distance_limit), stack_limit_(stack_limit),
+    stack_("(){}[]<>", stack_limit) {
   context_ = 0;
   size_ = 257 * distance_limit_;
 }
 
 void BracketContext::Update() {
-  if (!active_.empty()) {
-    if (brackets_[active_[active_.size() - 1]] == byte_ ||
-        distance_[distance_.size() - 1] >= distance_limit_ - 1) {
-      active_.pop_back();
-      distance_.pop_back();
+  if (!stack_.Empty()) {
+    if (stack_.Closer(stack_.Top()) == byte_ ||
+        stack_.Distance() >= distance_limit_ - 1) {
+      stack_.Pop();
     } else {
-      ++distance_[distance_.size() - 1];
+      stack_.Advance();
     }
   }
-  if (brackets_.find(byte_) != brackets_.end()) {
-    active_.push_back(byte_);
-    distance_.push_back(0);
-    if (brackets_.size() > stack_limit_) {
-      active_.erase(active_.begin());
-      distance_.erase(distance_.begin());
-    }
-  }
-  if (!active_.empty()) {
-    context_ = distance_limit_ * (active_[active_.size() - 1] + 1) +
-        distance_[distance_.size() - 1];
+  if (stack_.Closer(byte_)) stack_.Push(byte_);
+  if (!stack_.Empty()) {
+    context_ = distance_limit_ * (stack_.Top() + 1) + stack_.Distance();
   } else {
     context_ = 0;
   }
 }
 
-bool BracketContext::IsEqual(Context* c) {
-  BracketContext* p = dynamic_cast<BracketContext*>(c);
-  if (!p) return false;
-  if (distance_limit_ == p->distance_limit_ && stack_limit_ == p->stack_limit_)
+bool BracketContext::IsEqual(const BracketContext& c) const {
+  if (distance_limit_ == c.distance_limit_ && stack_limit_ == c.stack_limit_)
     return true;
   return false;
 }
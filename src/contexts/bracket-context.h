@@ -2,22 +2,19 @@
 #define BRACKET_CONTEXT_H
 
 #include "context.h"
-
-#include <unordered_map>
-#include <vector>
+#include "bracket-stack.h"
 
 class BracketContext : public Context {
  public:
   BracketContext(const unsigned int& bit_context, int distance_limit,
       int stack_limit);
   void Update();
-  bool IsEqual(Context* c);
+  bool IsEqual(const BracketContext& c) const;
 
  private:
   const unsigned int& byte_;
-  std::unordered_map<unsigned char, unsigned char> brackets_;
   unsigned int distance_limit_, stack_limit_;
-  std::vector<unsigned int> active_, distance_;
+  BracketStack stack_;
 };
 
 #endif
@@ -0,0 +1,26 @@
+#include "bracket-stack.h"
+
+BracketStack::BracketStack(const char* pairs, unsigned int stack_limit) :
+    brackets_(stack_limit, 0), distances_(stack_limit, 0), top_(0),
+    size_(0) {
+  for (int i = 0; i < 256; ++i) {
+    closers_[i] = 0;
+  }
+  for (; pairs[0] != 0 && pairs[1] != 0; pairs += 2) {
+    closers_[(unsigned char)pairs[0]] = pairs[1];
+  }
+}
+
+void BracketStack::Push(unsigned char c) {
+  ++top_;
+  if (top_ == brackets_.size()) top_ = 0;
+  brackets_[top_] = c;
+  distances_[top_] = 0;
+  if (size_ < brackets_.size()) ++size_;
+}
+
+void BracketStack::Pop() {
+  --size_;
+  if (top_ == 0) top_ = brackets_.size();
+  --top_;
+}
@@ -0,0 +1,29 @@
+#ifndef BRACKET_STACK_H
+#define BRACKET_STACK_H
+
+#include <vector>
+
+// The innermost open brackets and the number of bytes seen since each one
+// was opened. Holds at most stack_limit brackets: pushing onto a full stack
+// forgets the outermost one.
+class BracketStack {
+ public:
+  // pairs lists each opening bracket followed by its closing one.
+  BracketStack(const char* pairs, unsigned int stack_limit);
+  // The byte that closes c, or 0 if c is not an opening bracket.
+  unsigned char Closer(unsigned char c) const { return closers_[c]; }
+  bool Empty() const { return size_ == 0; }
+  unsigned char Top() const { return brackets_[top_]; }
+  unsigned int Distance() const { return distances_[top_]; }
+  void Push(unsigned char c);
+  void Pop();
+  void Advance() { ++distances_[top_]; }
+
+ private:
+  unsigned char closers_[256];
+  std::vector<unsigned char> brackets_;
+  std::vector<unsigned int> distances_;
+  unsigned int top_, size_;
+};
+
+#endif
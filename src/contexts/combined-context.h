@@ -9,7 +9,7 @@ class CombinedContext : public Context {
       context2, unsigned long long context1_size, unsigned long long
       context2_size);
   void Update();
-  bool IsEqual(Context* c);
+  bool IsEqual(const CombinedContext& c) const;
 
  private:
   const unsigned long long& context1_;
@@ -0,0 +1,30 @@
+#ifndef CONTEXT_ARRAY_H
+#define CONTEXT_ARRAY_H
+
+#include <deque>
+
+// The contexts of one concrete type, stored by value and updated in order
+// without virtual calls. A deque keeps the references returned by Add()
+// valid as more contexts are added.
+template <typename T>
+class ContextArray {
+ public:
+  // Returns an existing context equal to the given one, or stores it.
+  const T& Add(T&& context) {
+    for (const T& old : contexts_) {
+      if (old.IsEqual(context)) return old;
+    }
+    contexts_.push_back(std::move(context));
+    return contexts_.back();
+  }
+  void Update() {
+    for (T& context : contexts_) {
+      context.Update();
+    }
+  }
+
+ private:
+  std::deque<T> contexts_;
+};
+
+#endif
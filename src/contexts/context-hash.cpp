@@ -1,4 +1,5 @@
 #include "context-hash.h"
+#include "rolling-hash.h"
 
 ContextHash::ContextHash(const unsigned int& bit_context, unsigned int order,
     unsigned int hash_size) : byte_(bit_context), hash_size_(hash_size) {
@@ -7,12 +8,10 @@ ContextHash::ContextHash(const unsigned int& bit_context, unsigned int order,
 }
 
 void ContextHash::Update() {
-  context_ = (context_ * (1 << hash_size_) + byte_) % size_;
+  context_ = RollHash(context_, hash_size_, byte_, size_ - 1);
 }
 
-bool ContextHash::IsEqual(Context* c) {
-  ContextHash* p = dynamic_cast<ContextHash*>(c);
-  if (!p) return false;
-  if (size_ == p->size_ && hash_size_ == p->hash_size_) return true;
+bool ContextHash::IsEqual(const ContextHash& c) const {
+  if (size_ == c.size_ && hash_size_ == c.hash_size_) return true;
   return false;
 }
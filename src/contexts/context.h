@@ -1,11 +1,10 @@
 #ifndef CONTEXT_H
 #define CONTEXT_H
 
+// Base of the context types. Each type also provides Update() and
+// IsEqual(const Type&), which ContextManager calls on the concrete type.
 class Context {
  public:
-  virtual ~Context() {}
-  virtual void Update() {}
-  virtual bool IsEqual(Context* c) { return false; }
   const unsigned long long& GetContext() const { return context_; }
   unsigned long long Size() const { return size_; }
 
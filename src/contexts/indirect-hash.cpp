@@ -1,4 +1,5 @@
 #include "indirect-hash.h"
+#include "rolling-hash.h"
 
 IndirectHash::IndirectHash(const unsigned int& bit_context, unsigned int order1,
     unsigned int hash_size1, unsigned int order2, unsigned int hash_size2) :
@@ -11,16 +12,14 @@ IndirectHash::IndirectHash(const unsigned int& bit_context, unsigned int order1,
 }
 
 void IndirectHash::Update() {
-  hashes_[context1_] = (context_ * (1 << hash_size2_) + byte_) % size_;
-  context1_ = (context1_ * (1 << hash_size1_) + byte_) % size1_;
+  hashes_[context1_] = RollHash(context_, hash_size2_, byte_, size_ - 1);
+  context1_ = RollHash(context1_, hash_size1_, byte_, size1_ - 1);
   context_ = hashes_[context1_];
 }
 
-bool IndirectHash::IsEqual(Context* c) {
-  IndirectHash* p = dynamic_cast<IndirectHash*>(c);
-  if (!p) return false;
-  if (size_ == p->size_ && size1_ == p->size1_ &&
-      hash_size1_ == p->hash_size1_ && hash_size2_ == p->hash_size2_) {
+bool IndirectHash::IsEqual(const IndirectHash& c) const {
+  if (size_ == c.size_ && size1_ == c.size1_ &&
+      hash_size1_ == c.hash_size1_ && hash_size2_ == c.hash_size2_) {
     return true;
   }
   return false;
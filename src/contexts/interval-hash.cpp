@@ -1,4 +1,5 @@
 #include "interval-hash.h"
+#include "rolling-hash.h"
 
 IntervalHash::IntervalHash(const unsigned int& bit_context,
     const std::vector<int>& map, unsigned int num_bits, unsigned int order,
@@ -17,16 +18,14 @@ IntervalHash::IntervalHash(const unsigned int& bit_context,
 
 void IntervalHash::Update() {
   interval_ = mask_ & ((interval_ << shift_) + map_[byte_]);
-  context_ = (context_ * (1 << hash_size_) + interval_) % size_;
+  context_ = RollHash(context_, hash_size_, interval_, size_ - 1);
 }
 
-bool IntervalHash::IsEqual(Context* c) {
-  IntervalHash* p = dynamic_cast<IntervalHash*>(c);
-  if (!p) return false;
+bool IntervalHash::IsEqual(const IntervalHash& c) const {
   for (int i = 0; i < 256; ++i) {
-    if (p->map_[i] != map_[i]) return false;
+    if (c.map_[i] != map_[i]) return false;
   }
-  if (size_ != p->size_ || hash_size_ != p->hash_size_ ||
-    mask_ != p->mask_) return false;
+  if (size_ != c.size_ || hash_size_ != c.hash_size_ ||
+    mask_ != c.mask_) return false;
   return true;
 }
@@ -18,12 +18,10 @@ void Interval::Update() {
   context_ = mask_ & ((context_ << shift_) + map_[byte_]);
 }
 
-bool Interval::IsEqual(Context* c) {
-  Interval* p = dynamic_cast<Interval*>(c);
-  if (!p) return false;
-  if (p->size_ != size_) return false;
+bool Interval::IsEqual(const Interval& c) const {
+  if (c.size_ != size_) return false;
   for (int i = 0; i < 256; ++i) {
-    if (p->map_[i] != map_[i]) return false;
+    if (c.map_[i] != map_[i]) return false;
   }
   return true;
 }
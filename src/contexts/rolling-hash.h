@@ -0,0 +1,12 @@
+#ifndef ROLLING_HASH_H
+#define ROLLING_HASH_H
+
+// Shifts a symbol into a hash of the last few symbols. All order-N context
+// sizes are powers of two, so the reduction is a mask (size - 1) rather than
+// a 64-bit division.
+inline unsigned long long RollHash(unsigned long long hash, unsigned int shift,
+    unsigned long long symbol, unsigned long long mask) {
+  return ((hash << shift) + symbol) & mask;
+}
+
+#endif
@@ -21,13 +21,11 @@ void Sparse::Update() {
   }
 }
 
-bool Sparse::IsEqual(Context* c) {
-  Sparse* p = dynamic_cast<Sparse*>(c);
-  if (!p) return false;
-  if (&recent_contexts_ != &(p->recent_contexts_)) return false;
-  if (orders_.size() != p->orders_.size()) return false;
+bool Sparse::IsEqual(const Sparse& c) const {
+  if (&recent_contexts_ != &(c.recent_contexts_)) return false;
+  if (orders_.size() != c.orders_.size()) return false;
   for (unsigned int i = 0; i < orders_.size(); ++i) {
-    if (orders_[i] != p->orders_[i]) return false;
+    if (orders_[i] != c.orders_[i]) return false;
   }
   return true;
 }
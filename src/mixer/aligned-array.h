@@ -0,0 +1,38 @@
+#ifndef ALIGNED_ARRAY_H
+#define ALIGNED_ARRAY_H
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+// Zero-initialized float array whose first element starts on a 64-byte (cache
+// line) boundary.
+class AlignedArray {
+ public:
+  explicit AlignedArray(unsigned long long size) : storage_(size + 15, 0),
+      size_(size) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(&storage_[0]);
+    offset_ = ((64 - address % 64) % 64) / sizeof(float);
+  }
+  AlignedArray(const AlignedArray&) = delete;
+  AlignedArray& operator=(const AlignedArray&) = delete;
+  float* data() {return &storage_[offset_];}
+  const float* data() const {return &storage_[offset_];}
+  float& operator[](unsigned long long i) {return storage_[offset_ + i];}
+  float operator[](unsigned long long i) const {return storage_[offset_ + i];}
+  unsigned long long size() const {return size_;}
+  void Swap(AlignedArray* other) {
+    storage_.swap(other->storage_);
+    std::swap(size_, other->size_);
+    std::swap(offset_, other->offset_);
+  }
+  void Fill(float value) {
+    std::fill(data(), data() + size_, value);
+  }
+
+ private:
+  std::vector<float> storage_;
+  unsigned long long size_, offset_;
+};
+
+#endif
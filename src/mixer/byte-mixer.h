@@ -1,26 +1,36 @@
 #ifndef BYTE_MIXER_H
 #define BYTE_MIXER_H
 
+#include <valarray>
 #include <vector>
 
 #include "../models/byte-model.h"
-#include "lstm.h"
 
+// Combines the byte-level predictions of the byte models into one
+// distribution over the vocabulary. Subclasses provide the mixing engine.
 class ByteMixer : public ByteModel {
  public:
-  ByteMixer(unsigned int num_models, unsigned int num_cells,
-      unsigned int num_layers, int horizon, float learning_rate,
-      float gradient_clip, const unsigned int& bit_context,
+  ByteMixer(unsigned int num_models, const unsigned int& bit_context,
       const std::vector<bool>& vocab, unsigned int vocab_size);
-  void SetInput(int index, float val);
+  virtual ~ByteMixer() {}
+  // Adds the byte distribution of one byte model to the inputs.
+  void SetInputs(ByteModel* model);
   void ByteUpdate();
 
+ protected:
+  // Learns from the byte just seen (an index into the vocabulary) and returns
+  // the distribution over the vocabulary for the next byte. inputs[i] is
+  // twice the average probability the byte models gave to symbol i.
+  virtual const std::valarray<float>& Mix(const std::valarray<float>& inputs,
+      unsigned int symbol) = 0;
+
  private:
   const unsigned int& byte_;
-  Lstm lstm_;
   std::valarray<int> byte_map_;
+  std::vector<int> symbols_;
   std::valarray<float> inputs_;
-  unsigned int num_models_, vocab_size_, offset_;
+  float floor_;
+  unsigned int num_models_, vocab_size_;
 };
 
 #endif
@@ -0,0 +1,40 @@
+#include "gated-linear-byte-mixer.h"
+#include "portable-math.h"
+
+GatedLinearByteMixer::GatedLinearByteMixer(unsigned int num_models,
+    float learning_rate, const unsigned int& bit_context,
+    const std::vector<bool>& vocab, unsigned int vocab_size) :
+    ByteMixer(num_models, bit_context, vocab, vocab_size),
+    weights_(0.0f, 2 * (vocab_size + 1) * vocab_size),
+    features_(0.0f, vocab_size), output_(1.0f / vocab_size, vocab_size),
+    learning_rate_(learning_rate), vocab_size_(vocab_size), context_(0) {
+  float* shared = Weights(0);
+  for (unsigned int i = 0; i < vocab_size_; ++i) {
+    shared[i] = 1;
+  }
+}
+
+const std::valarray<float>& GatedLinearByteMixer::Mix(
+    const std::valarray<float>& inputs, unsigned int symbol) {
+  float* shared = Weights(0);
+  float* gated = Weights(1 + context_);
+  for (unsigned int i = 0; i < vocab_size_; ++i) {
+    float error = output_[i];
+    if (i == symbol) error -= 1;
+    error *= learning_rate_;
+    shared[i] -= error * features_[i];
+    gated[i] -= error * features_[i];
+    shared[vocab_size_ + i] -= error;
+    gated[vocab_size_ + i] -= error;
+  }
+
+  context_ = symbol;
+  gated = Weights(1 + context_);
+  for (unsigned int i = 0; i < vocab_size_; ++i) {
+    features_[i] = portable::Log(inputs[i] + 1.0e-4f);
+    output_[i] = (shared[i] + gated[i]) * features_[i] +
+        shared[vocab_size_ + i] + gated[vocab_size_ + i];
+  }
+  portable::Softmax(&output_[0], vocab_size_);
+  return output_;
+}
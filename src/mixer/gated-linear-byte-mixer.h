@@ -0,0 +1,32 @@
+#ifndef GATED_LINEAR_BYTE_MIXER_H
+#define GATED_LINEAR_BYTE_MIXER_H
+
+#include "byte-mixer.h"
+
+// A much cheaper alternative to LstmByteMixer: a softmax over one linear
+// function of the log input probability per symbol. The scale and bias of
+// each symbol are the sum of a shared set and a set selected by the previous
+// byte. Both are trained online on the cross entropy.
+class GatedLinearByteMixer : public ByteMixer {
+ public:
+  GatedLinearByteMixer(unsigned int num_models, float learning_rate,
+      const unsigned int& bit_context, const std::vector<bool>& vocab,
+      unsigned int vocab_size);
+
+ protected:
+  const std::valarray<float>& Mix(const std::valarray<float>& inputs,
+      unsigned int symbol);
+
+ private:
+  // Set 0 is shared, set 1 + s is used after symbol s. Each set holds
+  // vocab_size_ scales followed by vocab_size_ biases.
+  float* Weights(unsigned int set) {
+    return &weights_[2 * set * vocab_size_];
+  }
+
+  std::valarray<float> weights_, features_, output_;
+  float learning_rate_;
+  unsigned int vocab_size_, context_;
+};
+
+#endif
@@ -0,0 +1,19 @@
+#include "lstm-byte-mixer.h"
+
+LstmByteMixer::LstmByteMixer(unsigned int num_models, unsigned int num_cells,
+    unsigned int num_layers, int horizon, float learning_rate,
+    float gradient_clip, const unsigned int& bit_context,
+    const std::vector<bool>& vocab, unsigned int vocab_size,
+    unsigned int num_threads, bool deferred_training, bool half_precision) :
+    ByteMixer(num_models, bit_context, vocab, vocab_size),
+    lstm_(vocab_size, vocab_size, num_cells, num_layers, horizon,
+    learning_rate, gradient_clip, num_threads, deferred_training,
+    half_precision) {}
+
+const std::valarray<float>& LstmByteMixer::Mix(
+    const std::valarray<float>& inputs, unsigned int symbol) {
+  for (unsigned int i = 0; i < inputs.size(); ++i) {
+    lstm_.SetInput(i, inputs[i]);
+  }
+  return lstm_.Perceive(symbol);
+}
@@ -0,0 +1,23 @@
+#ifndef LSTM_BYTE_MIXER_H
+#define LSTM_BYTE_MIXER_H
+
+#include "byte-mixer.h"
+#include "lstm.h"
+
+class LstmByteMixer : public ByteMixer {
+ public:
+  LstmByteMixer(unsigned int num_models, unsigned int num_cells,
+      unsigned int num_layers, int horizon, float learning_rate,
+      float gradient_clip, const unsigned int& bit_context,
+      const std::vector<bool>& vocab, unsigned int vocab_size,
+      unsigned int num_threads, bool deferred_training, bool half_precision);
+
+ protected:
+  const std::valarray<float>& Mix(const std::valarray<float>& inputs,
+      unsigned int symbol);
+
+ private:
+  Lstm lstm_;
+};
+
+#endif
@@ -1,85 +1,218 @@
 #include "lstm-layer.h"
 
 #include "sigmoid.h"
+#include "portable-math.h"
 
 #include <math.h>
 #include <algorithm>
-#include <numeric>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace {
 
-void Adam(std::valarray<float>* g, std::valarray<float>* m,
-    std::valarray<float>* v, std::valarray<float>* w, float t) {
-  float beta1 = 0.9, beta2 = 0.999, alpha = 0.002 / sqrt(5e-5 * t + 1),
-      eps = 1e-8;
-  (*m) *= beta1;
-  (*m) += (1 - beta1) * (*g);
-  (*v) *= beta2;
-  (*v) += (1 - beta2) * (*g) * (*g);
-  (*w) -= alpha * (((*m) / (1 - pow(beta1, t))) /
-      (sqrt((*v) / (1 - pow(beta2, t))) + eps));
+// Computes eight columns of the gradient of four rows:
+// g[b * stride + k] = sum of errors[epoch * error_stride + b] *
+// inputs[epoch * stride + k], summed from the last epoch to the first. inputs
+// and g must be 32-byte aligned.
+void OuterProductSum(const float* errors, unsigned int error_stride,
+    const float* inputs, unsigned int stride, int horizon, float* g) {
+#if defined(__AVX__)
+  __m256 sum[4];
+  for (int b = 0; b < 4; ++b) sum[b] = _mm256_setzero_ps();
+  for (int epoch = horizon - 1; epoch >= 0; --epoch) {
+    __m256 x = _mm256_load_ps(inputs + epoch * stride);
+    const float* e = errors + epoch * error_stride;
+    for (int b = 0; b < 4; ++b) {
+      sum[b] = _mm256_add_ps(sum[b], _mm256_mul_ps(_mm256_set1_ps(e[b]), x));
+    }
+  }
+  for (int b = 0; b < 4; ++b) _mm256_store_ps(g + b * stride, sum[b]);
+#elif defined(__SSE2__)
+  __m128 sum[4][2];
+  for (int b = 0; b < 4; ++b) sum[b][0] = sum[b][1] = _mm_setzero_ps();
+  for (int epoch = horizon - 1; epoch >= 0; --epoch) {
+    __m128 x0 = _mm_load_ps(inputs + epoch * stride);
+    __m128 x1 = _mm_load_ps(inputs + epoch * stride + 4);
+    const float* e = errors + epoch * error_stride;
+    for (int b = 0; b < 4; ++b) {
+      __m128 eb = _mm_set1_ps(e[b]);
+      sum[b][0] = _mm_add_ps(sum[b][0], _mm_mul_ps(eb, x0));
+      sum[b][1] = _mm_add_ps(sum[b][1], _mm_mul_ps(eb, x1));
+    }
+  }
+  for (int b = 0; b < 4; ++b) {
+    _mm_store_ps(g + b * stride, sum[b][0]);
+    _mm_store_ps(g + b * stride + 4, sum[b][1]);
+  }
+#else
+  for (int b = 0; b < 4; ++b) {
+    for (int k = 0; k < 8; ++k) {
+      float sum = 0;
+      for (int epoch = horizon - 1; epoch >= 0; --epoch) {
+        sum += errors[epoch * error_stride + b] * inputs[epoch * stride + k];
+      }
+      g[b * stride + k] = sum;
+    }
+  }
+#endif
+}
+
+// y[j] += sum of rows[r][offset + j] * errors[r] over the rows, for j < n. The
+// sum for each j is accumulated in row order. Sixteen columns are kept in
+// registers while the rows are streamed through.
+void TransposedProduct(const float* const* rows, const float* errors,
+    int num_rows, int offset, int n, float* y) {
+  int j = 0;
+#if defined(__SSE2__)
+  for (; j + 16 <= n; j += 16) {
+    __m128 sum[4];
+    for (int k = 0; k < 4; ++k) sum[k] = _mm_loadu_ps(y + j + 4 * k);
+    for (int r = 0; r < num_rows; ++r) {
+      __m128 error = _mm_set1_ps(errors[r]);
+      const float* row = rows[r] + offset + j;
+      for (int k = 0; k < 4; ++k) {
+        sum[k] = _mm_add_ps(sum[k], _mm_mul_ps(_mm_loadu_ps(row + 4 * k),
+            error));
+      }
+    }
+    for (int k = 0; k < 4; ++k) _mm_storeu_ps(y + j + 4 * k, sum[k]);
+  }
+#endif
+  for (int r = 0; r < num_rows; ++r) {
+    for (int k = j; k < n; ++k) {
+      y[k] += rows[r][offset + k] * errors[r];
+    }
+  }
+}
+
+const float kBeta1 = 0.9, kBeta2 = 0.999;
+
+// Adam update of n weights in one pass, from w to w_out (which may be the
+// same array). The bias corrections of the current step are folded into
+// step_size and eps by the caller.
+void Adam(const float* g, float* m, float* v, const float* w, float* w_out,
+    unsigned long long n, float step_size, float eps) {
+  for (unsigned long long i = 0; i < n; ++i) {
+    m[i] = m[i] * kBeta1 + (1 - kBeta1) * g[i];
+    v[i] = v[i] * kBeta2 + (1 - kBeta2) * g[i] * g[i];
+    w_out[i] = w[i] - step_size * m[i] / (sqrtf(v[i]) + eps);
+  }
+}
+
+unsigned int RoundUp(unsigned int size, unsigned int multiple) {
+  return (size + multiple - 1) / multiple * multiple;
 }
 
 }
 
+LstmLayer::Records::Records(unsigned int num_cells, unsigned int horizon,
+    unsigned int stride) :
+    tanh_state(std::valarray<float>(num_cells), horizon),
+    output_gate_state(std::valarray<float>(num_cells), horizon),
+    input_node_state(std::valarray<float>(num_cells), horizon),
+    input_gate_state(std::valarray<float>(num_cells), horizon),
+    forget_gate_state(std::valarray<float>(num_cells), horizon),
+    last_state(std::valarray<float>(num_cells), horizon),
+    inputs(horizon * stride), input_symbols(horizon) {}
+
 LstmLayer::LstmLayer(unsigned int input_size, unsigned int auxiliary_input_size,
     unsigned int output_size, unsigned int num_cells, int horizon,
-    float gradient_clip) : state_(num_cells), output_gate_error_(num_cells),
+    float gradient_clip, ThreadPool* pool, bool deferred,
+    bool half_precision) :
+    state_(num_cells), output_gate_error_(num_cells),
     state_error_(num_cells), input_node_error_(num_cells),
     forget_gate_error_(num_cells), stored_error_(num_cells),
-    tanh_state_(std::valarray<float>(num_cells), horizon),
-    output_gate_state_(std::valarray<float>(num_cells), horizon),
-    input_node_state_(std::valarray<float>(num_cells), horizon),
-    input_gate_state_(std::valarray<float>(num_cells), horizon),
-    forget_gate_state_(std::valarray<float>(num_cells), horizon),
-    last_state_(std::valarray<float>(num_cells), horizon),
-    forget_gate_(std::valarray<float>(input_size), num_cells),
-    input_node_(std::valarray<float>(input_size), num_cells),
-    output_gate_(std::valarray<float>(input_size), num_cells),
-    forget_gate_update_(std::valarray<float>(input_size), num_cells),
-    input_node_update_(std::valarray<float>(input_size), num_cells),
-    output_gate_update_(std::valarray<float>(input_size), num_cells),
-    forget_gate_m_(std::valarray<float>(input_size), num_cells),
-    input_node_m_(std::valarray<float>(input_size), num_cells),
-    output_gate_m_(std::valarray<float>(input_size), num_cells),
-    forget_gate_v_(std::valarray<float>(input_size), num_cells),
-    input_node_v_(std::valarray<float>(input_size), num_cells),
-    output_gate_v_(std::valarray<float>(input_size), num_cells),
-    gradient_clip_(gradient_clip), num_cells_(num_cells), epoch_(0),
-    horizon_(horizon), input_size_(auxiliary_input_size),
-    output_size_(output_size) {
+    gates_(3 * num_cells), gradient_clip_(gradient_clip),
+    num_cells_(num_cells), epoch_(0), horizon_(horizon),
+    input_size_(auxiliary_input_size), output_size_(output_size),
+    num_inputs_(input_size - output_size), stride_(RoundUp(input_size, 16)),
+    deferred_(deferred), records_(new Records(num_cells, horizon, stride_)),
+    training_records_(deferred ? new Records(num_cells, horizon, stride_) :
+    nullptr), weights_(3 * num_cells * stride_),
+    next_weights_(deferred ? weights_.size() : 0), m_(weights_.size()),
+    v_(weights_.size()), half_precision_(half_precision),
+    half_weights_(half_precision ? weights_.size() : 0),
+    next_half_weights_(half_precision && deferred ? weights_.size() : 0),
+    gradient_(pool->NumThreads() * kBlock * stride_),
+    error_stride_(RoundUp(3 * num_cells, kBlock)),
+    gate_errors_(0.0f, error_stride_ * horizon), error_rows_(3 * num_cells),
+    row_errors_(3 * num_cells), pool_(pool) {
   float low = -0.2;
   float range = 0.4;
   for (unsigned int i = 0; i < num_cells_; ++i) {
-    for (unsigned int j = 0; j < forget_gate_[i].size(); ++j) {
-      forget_gate_[i][j] = low + Rand() * range;
-      input_node_[i][j] = low + Rand() * range;
-      output_gate_[i][j] = low + Rand() * range;
+    float* forget_gate = Row(&weights_, kForgetGate, i);
+    float* input_node = Row(&weights_, kInputNode, i);
+    float* output_gate = Row(&weights_, kOutputGate, i);
+    // Draws the random weights in the order of the old layout, in which the
+    // symbol weights came before the input weights.
+    for (unsigned int j = 0; j < input_size; ++j) {
+      unsigned int k = j < output_size_ ? num_inputs_ + j : j - output_size_;
+      forget_gate[k] = low + Rand() * range;
+      input_node[k] = low + Rand() * range;
+      output_gate[k] = low + Rand() * range;
     }
-    forget_gate_[i][forget_gate_[i].size() - 1] = 1;
+    forget_gate[num_inputs_ - 1] = 1;
+  }
+  for (unsigned long long i = 0; i < half_weights_.size(); ++i) {
+    half_weights_[i] = portable::ToBfloat16(weights_[i]);
+  }
+  SetErrorRows();
+}
+
+void LstmLayer::SetErrorRows() {
+  for (unsigned int i = 0; i < num_cells_; ++i) {
+    error_rows_[3 * i] = Row(&weights_, kInputNode, i) + input_size_;
+    error_rows_[3 * i + 1] = Row(&weights_, kForgetGate, i) + input_size_;
+    error_rows_[3 * i + 2] = Row(&weights_, kOutputGate, i) + input_size_;
   }
 }
 
+void LstmLayer::SwapRecords() {
+  std::swap(records_, training_records_);
+}
+
+void LstmLayer::ApplyUpdate() {
+  weights_.Swap(&next_weights_);
+  half_weights_.swap(next_half_weights_);
+  SetErrorRows();
+}
+
 void LstmLayer::ForwardPass(const std::valarray<float>& input, int input_symbol,
     std::valarray<float>* hidden, int hidden_start) {
-  last_state_[epoch_] = state_;
-  for (unsigned int i = 0; i < num_cells_; ++i) {
-    forget_gate_state_[epoch_][i] = Sigmoid::Logistic(std::inner_product(
-        &input[0], &input[input.size()],
-        &forget_gate_[i][output_size_], forget_gate_[i][input_symbol]));
-    input_node_state_[epoch_][i] = tanh(std::inner_product(&input[0],
-        &input[input.size()], &input_node_[i][output_size_],
-        input_node_[i][input_symbol]));
-    output_gate_state_[epoch_][i] = Sigmoid::Logistic(std::inner_product(
-        &input[0], &input[input.size()],
-        &output_gate_[i][output_size_], output_gate_[i][input_symbol]));
-  }
-  input_gate_state_[epoch_] = 1.0f - forget_gate_state_[epoch_];
-  state_ *= forget_gate_state_[epoch_];
-  state_ += input_node_state_[epoch_] * input_gate_state_[epoch_];
-  tanh_state_[epoch_] = tanh(state_);
+  Records& records = *records_;
+  records.last_state[epoch_] = state_;
+  std::copy(begin(input), end(input), records.inputs.data() +
+      epoch_ * stride_);
+  records.input_symbols[epoch_] = input_symbol;
+  std::valarray<float>& forget_gate = records.forget_gate_state[epoch_];
+  std::valarray<float>& input_node = records.input_node_state[epoch_];
+  std::valarray<float>& output_gate = records.output_gate_state[epoch_];
+  std::valarray<float>& input_gate = records.input_gate_state[epoch_];
+  std::valarray<float>& tanh_state = records.tanh_state[epoch_];
+  if (half_precision_) {
+    portable::MatrixVectorProduct(&half_weights_[0], stride_, 3 * num_cells_,
+        &input[0], num_inputs_, &gates_[0]);
+  } else {
+    portable::MatrixVectorProduct(weights_.data(), stride_, 3 * num_cells_,
+        &input[0], num_inputs_, &gates_[0]);
+  }
+  const float* symbol = weights_.data() + num_inputs_ + input_symbol;
+  for (unsigned int i = 0; i < 3 * num_cells_; ++i) {
+    gates_[i] += symbol[i * stride_];
+  }
+  Sigmoid::Logistic(&gates_[0], &forget_gate[0], num_cells_);
+  Sigmoid::Tanh(&gates_[num_cells_], &input_node[0], num_cells_);
+  Sigmoid::Logistic(&gates_[2 * num_cells_], &output_gate[0], num_cells_);
+  input_gate = 1.0f - forget_gate;
+  state_ *= forget_gate;
+  state_ += input_node * input_gate;
+  Sigmoid::Tanh(&state_[0], &tanh_state[0], num_cells_);
   std::slice slice = std::slice(hidden_start, num_cells_, 1);
-  (*hidden)[slice] = output_gate_state_[epoch_] * tanh_state_[epoch_];
+  (*hidden)[slice] = output_gate * tanh_state;
   ++epoch_;
   if (epoch_ == horizon_) epoch_ = 0;
 }
@@ -91,76 +224,125 @@ void LstmLayer::ClipGradients(std::valarray<float>* arr) {
   }
 }
 
-void LstmLayer::BackwardPass(const std::valarray<float>&input, int epoch,
-    int layer, int input_symbol, std::valarray<float>* hidden_error) {
+void LstmLayer::BackwardPass(int epoch, int layer,
+    std::valarray<float>* hidden_error) {
   if (epoch == (int)horizon_ - 1) {
     stored_error_ = *hidden_error;
     state_error_ = 0;
-    for (unsigned int i = 0; i < num_cells_; ++i) {
-      forget_gate_update_[i] = 0;
-      input_node_update_[i] = 0;
-      output_gate_update_[i] = 0;
-    }
   } else {
     stored_error_ += *hidden_error;
   }
 
-  output_gate_error_ = tanh_state_[epoch] * stored_error_ *
-      output_gate_state_[epoch] * (1.0f - output_gate_state_[epoch]);
-  state_error_ += stored_error_ * output_gate_state_[epoch] * (1.0f -
-      (tanh_state_[epoch] * tanh_state_[epoch]));
-  input_node_error_ = state_error_ * input_gate_state_[epoch] * (1.0f -
-      (input_node_state_[epoch] * input_node_state_[epoch]));
-  forget_gate_error_ = (last_state_[epoch] - input_node_state_[epoch]) *
-      state_error_ * forget_gate_state_[epoch] * input_gate_state_[epoch];
+  const Records& records = TrainingRecords();
+  const std::valarray<float>& tanh_state = records.tanh_state[epoch];
+  const std::valarray<float>& output_gate = records.output_gate_state[epoch];
+  const std::valarray<float>& input_node = records.input_node_state[epoch];
+  const std::valarray<float>& input_gate = records.input_gate_state[epoch];
+  const std::valarray<float>& forget_gate = records.forget_gate_state[epoch];
+  output_gate_error_ = tanh_state * stored_error_ * output_gate *
+      (1.0f - output_gate);
+  state_error_ += stored_error_ * output_gate * (1.0f -
+      (tanh_state * tanh_state));
+  input_node_error_ = state_error_ * input_gate * (1.0f -
+      (input_node * input_node));
+  forget_gate_error_ = (records.last_state[epoch] - input_node) *
+      state_error_ * forget_gate * input_gate;
 
-  *hidden_error = 0;
-  if (layer > 0) {
-    int offset = output_size_ + num_cells_ + input_size_;
-    for (unsigned int i = 0; i < num_cells_; ++i) {
-      for (unsigned int j = offset; j < offset + num_cells_; ++j) {
-        (*hidden_error)[j-offset] += input_node_[i][j] * input_node_error_[i];
-        (*hidden_error)[j-offset] += forget_gate_[i][j] * forget_gate_error_[i];
-        (*hidden_error)[j-offset] += output_gate_[i][j] * output_gate_error_[i];
-      }
-    }
+  // Error of the hidden inputs (W^T * gate error). Columns input_size_ +
+  // num_cells_ onwards hold the previous layer's output, columns input_size_
+  // onwards this layer's output at the previous epoch.
+  for (unsigned int i = 0; i < num_cells_; ++i) {
+    row_errors_[3 * i] = input_node_error_[i];
+    row_errors_[3 * i + 1] = forget_gate_error_[i];
+    row_errors_[3 * i + 2] = output_gate_error_[i];
   }
-
+  *hidden_error = 0;
   if (epoch > 0) {
-    state_error_ *= forget_gate_state_[epoch];
+    state_error_ *= forget_gate;
     stored_error_ = 0;
-    int offset = output_size_ + input_size_;
-    for (unsigned int i = 0; i < num_cells_; ++i) {
-      for (unsigned int j = offset; j < offset + num_cells_; ++j) {
-        stored_error_[j-offset] += input_node_[i][j] * input_node_error_[i];
-        stored_error_[j-offset] += forget_gate_[i][j] * forget_gate_error_[i];
-        stored_error_[j-offset] += output_gate_[i][j] * output_gate_error_[i];
-      }
-    }
   }
+  // Threads get whole 16-column chunks, so the columns that take the scalar
+  // path do not depend on the thread count.
+  float* hidden = &(*hidden_error)[0];
+  float* stored = &stored_error_[0];
+  pool_->Run((num_cells_ + 15) / 16, [&](unsigned int thread,
+      unsigned int begin, unsigned int end) {
+    unsigned int j = begin * 16;
+    unsigned int n = std::min(end * 16, num_cells_) - j;
+    if (layer > 0) {
+      TransposedProduct(&error_rows_[0], &row_errors_[0], 3 * num_cells_,
+          num_cells_ + j, n, hidden + j);
+    }
+    if (epoch > 0) {
+      TransposedProduct(&error_rows_[0], &row_errors_[0], 3 * num_cells_, j,
+          n, stored + j);
+    }
+  });
 
   ClipGradients(&state_error_);
   ClipGradients(&stored_error_);
   ClipGradients(hidden_error);
 
-  std::slice slice = std::slice(output_size_, input.size(), 1);
+  float* gate_errors = &gate_errors_[epoch * error_stride_];
   for (unsigned int i = 0; i < num_cells_; ++i) {
-    forget_gate_update_[i][slice] += forget_gate_error_[i] * input;
-    input_node_update_[i][slice] += input_node_error_[i] * input;
-    output_gate_update_[i][slice] += output_gate_error_[i] * input;
-    forget_gate_update_[i][input_symbol] += forget_gate_error_[i];
-    input_node_update_[i][input_symbol] += input_node_error_[i];
-    output_gate_update_[i][input_symbol] += output_gate_error_[i];
-  }
-  if (epoch == 0) {
-    ++update_steps_;
-    for (unsigned int i = 0; i < num_cells_; ++i) {
-      Adam(&forget_gate_update_[i], &forget_gate_m_[i], &forget_gate_v_[i],
-          &forget_gate_[i], update_steps_);
-      Adam(&input_node_update_[i], &input_node_m_[i], &input_node_v_[i],
-          &input_node_[i], update_steps_);
-      Adam(&output_gate_update_[i], &output_gate_m_[i], &output_gate_v_[i],
-          &output_gate_[i], update_steps_);
+    gate_errors[kForgetGate * num_cells_ + i] = forget_gate_error_[i];
+    gate_errors[kInputNode * num_cells_ + i] = input_node_error_[i];
+    gate_errors[kOutputGate * num_cells_ + i] = output_gate_error_[i];
+  }
+  if (epoch == 0) UpdateWeights();
+}
+
+void LstmLayer::UpdateWeights() {
+  ++update_steps_;
+  float t = update_steps_;
+  float alpha = 0.002 / sqrt(5e-5 * t + 1);
+  double bias1 = 1 - portable::Pow(kBeta1, t);
+  double bias2 = 1 - portable::Pow(kBeta2, t);
+  float step_size = alpha * sqrt(bias2) / bias1;
+  float eps = 1e-8 * sqrt(bias2);
+  // The gradient of a row is the sum over the horizon of the outer product of
+  // its gate error and the recorded input. It is accumulated for a block of
+  // rows at a time, so that each recorded input is read once per block, and
+  // the Adam step is applied while the block is still in cache. Blocks are
+  // independent, so they are split between the threads.
+  unsigned int num_blocks = (3 * num_cells_ + kBlock - 1) / kBlock;
+  pool_->Run(num_blocks, [&](unsigned int thread, unsigned int begin,
+      unsigned int end) {
+    float* gradient = gradient_.data() + thread * kBlock * stride_;
+    for (unsigned int i = begin; i < end; ++i) {
+      UpdateBlock(i * kBlock, gradient, step_size, eps);
+    }
+  });
+}
+
+void LstmLayer::UpdateBlock(unsigned int row, float* gradient,
+    float step_size, float eps) {
+  const Records& records = TrainingRecords();
+  unsigned int block = std::min(3 * num_cells_ - row, 0u + kBlock);
+  // Eight columns of the block are accumulated in registers over the whole
+  // horizon. Recorded inputs are zero past num_inputs_.
+  for (unsigned int j = 0; j < num_inputs_; j += 8) {
+    OuterProductSum(&gate_errors_[row], error_stride_,
+        records.inputs.data() + j, stride_, horizon_, gradient + j);
+  }
+  for (unsigned int b = 0; b < block; ++b) {
+    float* g = gradient + b * stride_;
+    std::fill(g + num_inputs_, g + stride_, 0.0f);
+    for (int epoch = horizon_ - 1; epoch >= 0; --epoch) {
+      g[num_inputs_ + records.input_symbols[epoch]] +=
+          gate_errors_[epoch * error_stride_ + row + b];
+    }
+  }
+  unsigned long long offset = row * stride_;
+  float* updated = deferred_ ? next_weights_.data() : weights_.data();
+  Adam(gradient, m_.data() + offset, v_.data() + offset,
+      weights_.data() + offset, updated + offset, block * stride_, step_size,
+      eps);
+  if (half_precision_) {
+    unsigned short* half = deferred_ ? &next_half_weights_[offset] :
+        &half_weights_[offset];
+    for (unsigned long long i = 0; i < block * stride_; ++i) {
+      half[i] = portable::ToBfloat16(updated[offset + i]);
     }
   }
 }
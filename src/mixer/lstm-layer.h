@@ -1,7 +1,12 @@
 #ifndef LSTM_LAYER_H
 #define LSTM_LAYER_H
 
+#include "aligned-array.h"
+#include "thread-pool.h"
+
 #include <valarray>
+#include <vector>
+#include <memory>
 #include <stdlib.h>
 #include <math.h>
 
@@ -9,28 +14,80 @@ class LstmLayer {
  public:
   LstmLayer(unsigned int input_size, unsigned int auxiliary_input_size,
       unsigned int output_size, unsigned int num_cells, int horizon,
-      float gradient_clip);
+      float gradient_clip, ThreadPool* pool, bool deferred,
+      bool half_precision);
   void ForwardPass(const std::valarray<float>& input, int input_symbol,
       std::valarray<float>* hidden, int hidden_start);
-  void BackwardPass(const std::valarray<float>& input, int epoch,
-      int layer, int input_symbol, std::valarray<float>* hidden_error);
+  void BackwardPass(int epoch, int layer, std::valarray<float>* hidden_error);
+  // Deferred training only. SwapRecords() hands the values recorded during
+  // the last horizon to the backward pass, and the forward pass records the
+  // next horizon into the other set. ApplyUpdate() makes the weights computed
+  // by the last backward sweep current.
+  void SwapRecords();
+  void ApplyUpdate();
   static inline float Rand() {
     return static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
   }
 
  private:
+  // Weights of the three gates in one matrix of 3 * num_cells_ rows: the
+  // forget gate rows come first, then the input node rows, then the output
+  // gate rows. A row holds num_inputs_ input weights followed by output_size_
+  // input symbol weights and is padded to stride_ floats, so every row starts
+  // on a cache line.
+  enum Gate {kForgetGate = 0, kInputNode = 1, kOutputGate = 2};
+  float* Row(AlignedArray* matrix, Gate gate, unsigned int cell) {
+    return matrix->data() + (gate * num_cells_ + cell) * stride_;
+  }
+
+  // Values recorded by the forward pass for each epoch of the horizon, read
+  // by the backward pass.
+  struct Records {
+    Records(unsigned int num_cells, unsigned int horizon, unsigned int stride);
+    std::valarray<std::valarray<float>> tanh_state, output_gate_state,
+        input_node_state, input_gate_state, forget_gate_state, last_state;
+    AlignedArray inputs;
+    std::valarray<unsigned int> input_symbols;
+  };
+  Records& TrainingRecords() {
+    return deferred_ ? *training_records_ : *records_;
+  }
+  void SetErrorRows();
+
   std::valarray<float> state_, output_gate_error_, state_error_,
-      input_node_error_, forget_gate_error_, stored_error_;
-  std::valarray<std::valarray<float>> tanh_state_, output_gate_state_,
-      input_node_state_, input_gate_state_, forget_gate_state_, last_state_,
-      forget_gate_, input_node_, output_gate_, forget_gate_update_,
-      input_node_update_, output_gate_update_, forget_gate_m_, input_node_m_,
-      output_gate_m_, forget_gate_v_, input_node_v_, output_gate_v_;
+      input_node_error_, forget_gate_error_, stored_error_, gates_;
   float gradient_clip_;
-  unsigned int num_cells_, epoch_, horizon_, input_size_, output_size_;
+  unsigned int num_cells_, epoch_, horizon_, input_size_, output_size_,
+      num_inputs_, stride_;
+  bool deferred_;
+  std::unique_ptr<Records> records_, training_records_;
+  // With deferred training, the backward pass writes the updated weights to
+  // next_weights_ while the forward pass keeps using weights_.
+  AlignedArray weights_, next_weights_, m_, v_;
+  // In half precision mode the forward pass reads the input weights from a
+  // bfloat16 copy, which is refreshed as each block of rows is updated.
+  // Training keeps using the single precision weights.
+  bool half_precision_;
+  std::vector<unsigned short> half_weights_, next_half_weights_;
+  // The gate errors of each epoch in row order (padded to a multiple of kBlock
+  // rows). The weights are updated from these and the recorded inputs once
+  // per horizon, kBlock rows at a time, with one gradient buffer of kBlock
+  // rows per thread.
+  static const unsigned int kBlock = 4;
+  AlignedArray gradient_;
+  unsigned int error_stride_;
+  std::valarray<float> gate_errors_;
+  // Recurrent weight rows and their gate errors, in the order in which the
+  // error of the hidden inputs is accumulated.
+  std::vector<const float*> error_rows_;
+  std::valarray<float> row_errors_;
+  ThreadPool* pool_;
   unsigned long long update_steps_ = 0;
 
   void ClipGradients(std::valarray<float>* arr);
+  void UpdateWeights();
+  void UpdateBlock(unsigned int row, float* gradient, float step_size,
+      float eps);
 };
 
 #endif
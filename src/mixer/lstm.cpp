@@ -1,20 +1,76 @@
 #include "lstm.h"
+#include "portable-math.h"
 
 #include <numeric>
+#include <algorithm>
 #include <stdlib.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// y[e][j] = sum of rows[r][j] * errors[e][r] over the rows, for e < 4 and
+// begin <= j < end. The sum for each j is accumulated in row order. Each load
+// of a row is shared by the four error vectors.
+void TransposedProduct4(const float* const* rows, int num_rows,
+    const float* const* errors, int begin, int end, float* const* y) {
+  int j = begin;
+#if defined(__SSE2__)
+  for (; j + 8 <= end; j += 8) {
+    __m128 sum[4][2];
+    for (int e = 0; e < 4; ++e) sum[e][0] = sum[e][1] = _mm_setzero_ps();
+    for (int r = 0; r < num_rows; ++r) {
+      __m128 w0 = _mm_loadu_ps(rows[r] + j);
+      __m128 w1 = _mm_loadu_ps(rows[r] + j + 4);
+      for (int e = 0; e < 4; ++e) {
+        __m128 error = _mm_set1_ps(errors[e][r]);
+        sum[e][0] = _mm_add_ps(sum[e][0], _mm_mul_ps(w0, error));
+        sum[e][1] = _mm_add_ps(sum[e][1], _mm_mul_ps(w1, error));
+      }
+    }
+    for (int e = 0; e < 4; ++e) {
+      _mm_storeu_ps(y[e] + j, sum[e][0]);
+      _mm_storeu_ps(y[e] + j + 4, sum[e][1]);
+    }
+  }
+#endif
+  for (int e = 0; e < 4; ++e) {
+    for (int k = j; k < end; ++k) {
+      float sum = 0;
+      for (int r = 0; r < num_rows; ++r) {
+        sum += rows[r][k] * errors[e][r];
+      }
+      y[e][k] = sum;
+    }
+  }
+}
+
+}  // namespace
+
 Lstm::Lstm(unsigned int input_size, unsigned int output_size, unsigned int
     num_cells, unsigned int num_layers, int horizon, float learning_rate,
-    float gradient_clip) : input_history_(horizon),
+    float gradient_clip, unsigned int num_threads, bool deferred,
+    bool half_precision) :
+    pool_(num_threads),
+    training_pool_(deferred ? new ThreadPool(num_threads) : nullptr),
+    input_history_(horizon),
     hidden_(num_cells * num_layers + 1), hidden_error_(num_cells),
+    coefficients_(horizon),
     layer_input_(std::valarray<std::valarray<float>>(std::valarray<float>
     (input_size + 1 + num_cells * 2), num_layers), horizon),
-    output_layer_(std::valarray<std::valarray<float>>(std::valarray<float>
-    (num_cells * num_layers + 1), output_size), horizon),
+    projected_error_(std::valarray<float>(num_cells * num_layers),
+    (horizon + 3) / 4 * 4),
+    output_layer_(std::valarray<float>(num_cells * num_layers + 1),
+    output_size),
     output_(std::valarray<float>(1.0 / output_size, output_size), horizon),
-    learning_rate_(learning_rate), num_cells_(num_cells), epoch_(0),
-    horizon_(horizon), input_size_(input_size), output_size_(output_size) {
+    output_error_(std::valarray<float>(output_size), horizon),
+    deferred_(deferred), learning_rate_(learning_rate), num_cells_(num_cells),
+    epoch_(0), horizon_(horizon), input_size_(input_size),
+    output_size_(output_size) {
   hidden_[hidden_.size() - 1] = 1;
+  hidden_history_.resize(horizon, hidden_);
   for (int epoch = 0; epoch < horizon; ++epoch) {
     layer_input_[epoch][0].resize(1 + num_cells + input_size);
     for (unsigned int i = 0; i < num_layers; ++i) {
@@ -24,10 +80,16 @@ Lstm::Lstm(unsigned int input_size, unsigned int output_size, unsigned int
   for (unsigned int i = 0; i < num_layers; ++i) {
     layers_.push_back(std::unique_ptr<LstmLayer>(new LstmLayer(
         layer_input_[0][i].size() + output_size, input_size_, output_size_,
-        num_cells, horizon, gradient_clip)));
+        num_cells, horizon, gradient_clip,
+        deferred ? training_pool_.get() : &pool_, deferred,
+        half_precision)));
   }
 }
 
+Lstm::~Lstm() {
+  if (training_.joinable()) training_.join();
+}
+
 void Lstm::SetInput(int index, float val) {
   for (unsigned int i = 0; i < layers_.size(); ++i) {
     layer_input_[epoch_][i][index] = val;
@@ -37,38 +99,90 @@ void Lstm::SetInput(int index, float val) {
 std::valarray<float>& Lstm::Perceive(unsigned int input) {
   int last_epoch = epoch_ - 1;
   if (last_epoch == -1) last_epoch = horizon_ - 1;
-  int old_input = input_history_[last_epoch];
   input_history_[last_epoch] = input;
+  output_error_[last_epoch] = output_[last_epoch];
+  output_error_[last_epoch][input] -= 1;
   if (epoch_ == 0) {
-    for (int epoch = horizon_ - 1; epoch >= 0; --epoch) {
-      for (int layer = layers_.size() - 1; layer >= 0; --layer) {
-        int offset = layer * num_cells_;
-        for (unsigned int i = 0; i < output_size_; ++i) {
-          float error = 0;
-          if (i == input_history_[epoch]) error = output_[epoch][i] - 1;
-          else error = output_[epoch][i];
-          for (unsigned int j = 0; j < hidden_error_.size(); ++j) {
-            hidden_error_[j] += output_layer_[epoch][i][j + offset] * error;
+    if (deferred_) {
+      StartTraining();
+    } else {
+      Train(output_layer_, output_error_, hidden_history_);
+    }
+  }
+  return Predict(input);
+}
+
+void Lstm::Train(const std::valarray<std::valarray<float>>& output_layer,
+    const std::valarray<std::valarray<float>>& output_error,
+    const std::valarray<std::valarray<float>>& hidden_history) {
+  // W^T * e for every epoch, computed in one pass over the output layer.
+  // Threads get whole chunks of eight columns, so the columns that take the
+  // scalar path do not depend on the thread count.
+  unsigned int num_epochs = projected_error_.size();
+  std::vector<const float*> rows(output_size_), errors(num_epochs);
+  std::vector<float*> projected(num_epochs);
+  for (unsigned int i = 0; i < output_size_; ++i) {
+    rows[i] = &output_layer[i][0];
+  }
+  for (unsigned int epoch = 0; epoch < num_epochs; ++epoch) {
+    errors[epoch] = &output_error[std::min(epoch, horizon_ - 1)][0];
+    projected[epoch] = &projected_error_[epoch][0];
+  }
+  unsigned int num_columns = projected_error_[0].size();
+  ThreadPool* pool = deferred_ ? training_pool_.get() : &pool_;
+  pool->Run((num_columns + 7) / 8, [&](unsigned int thread,
+      unsigned int begin, unsigned int end) {
+    for (unsigned int epoch = 0; epoch < num_epochs; epoch += 4) {
+      TransposedProduct4(&rows[0], output_size_, &errors[epoch], begin * 8,
+          std::min(end * 8, num_columns), &projected[epoch]);
+    }
+  });
+  for (int epoch = horizon_ - 1; epoch >= 0; --epoch) {
+    // The output layer used at this epoch differs from the current one by
+    // the updates of the later epochs, so its contribution to the hidden
+    // error is W^T * e plus learning_rate_ * (e_k . e) * h_k for each of
+    // those epochs k.
+    const std::valarray<float>& error = output_error[epoch];
+    for (int k = epoch; k < (int)horizon_ - 1; ++k) {
+      coefficients_[k] = learning_rate_ * portable::DotProduct(
+          &output_error[k][0], &error[0], output_size_);
+    }
+    for (int layer = layers_.size() - 1; layer >= 0; --layer) {
+      int offset = layer * num_cells_;
+      pool->Run(num_cells_, [&](unsigned int thread, unsigned int begin,
+          unsigned int end) {
+        const float* product = &projected_error_[epoch][offset];
+        for (unsigned int j = begin; j < end; ++j) {
+          hidden_error_[j] += product[j];
+        }
+        for (int k = epoch; k < (int)horizon_ - 1; ++k) {
+          const float* hidden = &hidden_history[k][offset];
+          for (unsigned int j = begin; j < end; ++j) {
+            hidden_error_[j] += coefficients_[k] * hidden[j];
           }
         }
-        int prev_epoch = epoch - 1;
-        if (prev_epoch == -1) prev_epoch = horizon_ - 1;
-        int input_symbol = input_history_[prev_epoch];
-        if (epoch == 0) input_symbol = old_input;
-        layers_[layer]->BackwardPass(layer_input_[epoch][layer], epoch, layer,
-            input_symbol, &hidden_error_);
-      }
+      });
+      layers_[layer]->BackwardPass(epoch, layer, &hidden_error_);
     }
   }
+}
 
-  output_layer_[epoch_] = output_layer_[last_epoch];
-  for (unsigned int i = 0; i < output_size_; ++i) {
-    float error = 0;
-    if (i == input) error = output_[last_epoch][i] - 1;
-    else error = output_[last_epoch][i];
-    output_layer_[epoch_][i] -= learning_rate_ * error * hidden_;
+void Lstm::StartTraining() {
+  if (training_.joinable()) {
+    training_.join();
+    for (auto& layer : layers_) {
+      layer->ApplyUpdate();
+    }
   }
-  return Predict(input);
+  for (auto& layer : layers_) {
+    layer->SwapRecords();
+  }
+  train_output_layer_ = output_layer_;
+  train_output_error_ = output_error_;
+  train_hidden_history_ = hidden_history_;
+  training_ = std::thread([this] {
+    Train(train_output_layer_, train_output_error_, train_hidden_history_);
+  });
 }
 
 std::valarray<float>& Lstm::Predict(unsigned int input) {
@@ -84,10 +198,22 @@ std::valarray<float>& Lstm::Predict(unsigned int input) {
       std::copy(start, start + num_cells_, start2);
     }
   }
-  for (unsigned int i = 0; i < output_size_; ++i) {
-    output_[epoch_][i] = exp((hidden_ * output_layer_[epoch_][i]).sum());
-  }
-  output_[epoch_] /= output_[epoch_].sum();
+  // The update of each output row for the previous epoch is applied just
+  // before the row is used, so the matrix is only traversed once per byte.
+  int last_epoch = epoch_ - 1;
+  if (last_epoch == -1) last_epoch = horizon_ - 1;
+  const std::valarray<float>& last_hidden = hidden_history_[last_epoch];
+  pool_.Run(output_size_, [&](unsigned int thread, unsigned int begin,
+      unsigned int end) {
+    for (unsigned int i = begin; i < end; ++i) {
+      output_layer_[i] -= learning_rate_ * output_error_[last_epoch][i] *
+          last_hidden;
+      output_[epoch_][i] = portable::DotProduct(&hidden_[0],
+          &output_layer_[i][0], hidden_.size());
+    }
+  });
+  portable::Softmax(&output_[epoch_][0], output_size_);
+  hidden_history_[epoch_] = hidden_;
   int epoch = epoch_;
   ++epoch_;
   if (epoch_ == horizon_) epoch_ = 0;
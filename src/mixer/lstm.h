@@ -4,25 +4,52 @@
 #include <valarray>
 #include <vector>
 #include <memory>
+#include <thread>
 
 #include "lstm-layer.h"
+#include "thread-pool.h"
 
 class Lstm {
  public:
   Lstm(unsigned int input_size, unsigned int output_size, unsigned int
       num_cells, unsigned int num_layers, int horizon, float learning_rate,
-      float gradient_clip);
+      float gradient_clip, unsigned int num_threads, bool deferred,
+      bool half_precision);
+  ~Lstm();
   std::valarray<float>& Perceive(unsigned int input);
-  std::valarray<float>& Predict(unsigned int input);
   void SetInput(int index, float val);
 
  private:
+  std::valarray<float>& Predict(unsigned int input);
+  void Train(const std::valarray<std::valarray<float>>& output_layer,
+      const std::valarray<std::valarray<float>>& output_error,
+      const std::valarray<std::valarray<float>>& hidden_history);
+  void StartTraining();
+
+  ThreadPool pool_;
+  // With deferred training the backward pass gets its own threads, so it
+  // neither waits for nor holds up the output layer of the forward pass.
+  std::unique_ptr<ThreadPool> training_pool_;
   std::vector<std::unique_ptr<LstmLayer>> layers_;
   std::vector<unsigned int> input_history_;
-  std::valarray<float> hidden_, hidden_error_;
-  std::valarray<std::valarray<std::valarray<float>>> layer_input_,
-      output_layer_;
-  std::valarray<std::valarray<float>> output_;
+  std::valarray<float> hidden_, hidden_error_, coefficients_;
+  std::valarray<std::valarray<std::valarray<float>>> layer_input_;
+  // The output layer's contribution W^T * e to the hidden error of each
+  // epoch. Padded to a multiple of four epochs.
+  std::valarray<std::valarray<float>> projected_error_;
+  // Only the current output layer is kept. The one used at an earlier epoch
+  // of the horizon is the current one plus the updates made since, which are
+  // rebuilt from output_error_ and hidden_history_ during training.
+  std::valarray<std::valarray<float>> output_layer_, output_, output_error_,
+      hidden_history_;
+  // With deferred training, the backward pass over a horizon runs on
+  // training_ from copies of the values above while the next horizon is
+  // coded. Its weight updates are applied at the start of the following
+  // horizon, so the output only depends on the data.
+  bool deferred_;
+  std::thread training_;
+  std::valarray<std::valarray<float>> train_output_layer_,
+      train_output_error_, train_hidden_history_;
   float learning_rate_;
   unsigned int num_cells_, epoch_, horizon_, input_size_, output_size_;
 };
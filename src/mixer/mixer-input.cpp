@@ -1,14 +1,46 @@
 #include "mixer-input.h"
 
-MixerInput::MixerInput(const Sigmoid& sigmoid, float eps) :
-    inputs_(0.5, 1), sigmoid_(sigmoid), min_(eps), max_(1 - eps) {}
+MixerInput::MixerInput(float eps, bool quantized) : inputs_(0.5, 1),
+    quantized_inputs_(8), min_(eps), max_(1 - eps), quantized_(quantized) {
+  if (quantized_) Quantize(0);
+}
 
 void MixerInput::SetNumModels(int num_models) {
   inputs_.resize(num_models, 0.5);
+  if (!quantized_) return;
+  quantized_inputs_.resize((num_models + 7) & -8, 0);
+  for (int i = 0; i < num_models; ++i) {
+    Quantize(i);
+  }
 }
 
 void MixerInput::SetInput(int index, float p) {
   if (p < min_) p = min_;
   else if (p > max_) p = max_;
-  inputs_[index] = sigmoid_.Logit(p);
+  inputs_[index] = Sigmoid::Logit(p);
+  if (quantized_) Quantize(index);
+}
+
+void MixerInput::SetInputs(int index, const std::valarray<float>& p) {
+  float* inputs = &inputs_[index];
+  int n = p.size();
+  for (int i = 0; i < n; ++i) {
+    float x = p[i];
+    x = x < min_ ? min_ : x;
+    x = x > max_ ? max_ : x;
+    inputs[i] = x;
+  }
+  Sigmoid::Logit(inputs, inputs, n);
+  if (quantized_) {
+    for (int i = 0; i < n; ++i) {
+      Quantize(index + i);
+    }
+  }
+}
+
+void MixerInput::Quantize(int index) {
+  float x = inputs_[index] * 256;
+  if (x < -8191) x = -8191;
+  else if (x > 8191) x = 8191;
+  quantized_inputs_[index] = x < 0 ? x - 0.5f : x + 0.5f;
 }
@@ -7,16 +7,29 @@
 
 class MixerInput {
  public:
-  MixerInput(const Sigmoid& sigmoid, float eps);
+  MixerInput(float eps, bool quantized = false);
   void SetNumModels(int num_models);
   void SetInput(int index, float p);
-  void SetStretchedInput(int index, float p) { inputs_[index] = p; }
+  // Same as calling SetInput(index + i, p[i]) for every element of p.
+  void SetInputs(int index, const std::valarray<float>& p);
+  void SetStretchedInput(int index, float p) {
+    inputs_[index] = p;
+    if (quantized_) Quantize(index);
+  }
   const std::valarray<float>& Inputs() const { return inputs_; }
+  // Copy of the inputs in 8.8 fixed-point (padded to a multiple of 8), only
+  // maintained when the layer is quantized.
+  const std::valarray<short>& QuantizedInputs() const {
+    return quantized_inputs_;
+  }
+  bool IsQuantized() const { return quantized_; }
 
  private:
+  void Quantize(int index);
   std::valarray<float> inputs_;
-  const Sigmoid& sigmoid_;
+  std::valarray<short> quantized_inputs_;
   float min_, max_;
+  bool quantized_;
 };
 
 #endif
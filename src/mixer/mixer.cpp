@@ -1,9 +1,7 @@
 #include "mixer.h"
 
 #include "sigmoid.h"
-
-#include <numeric>
-#include <math.h>
+#include "portable-math.h"
 
 Mixer::Mixer(const std::valarray<float>& inputs,
     const unsigned long long& context, float learning_rate,
@@ -23,20 +21,24 @@ ContextData* Mixer::GetContextData() {
 
 float Mixer::Mix() {
   ContextData* data = GetContextData();
-  p_ = (inputs_ * data->weights).sum();
+  p_ = portable::DotProduct(&inputs_[0], &data->weights[0], input_size_);
   return p_;
 }
 
-void Mixer::Perceive(int bit) {
-  ContextData* data = GetContextData();
-  float decay = 0.9 / pow(0.0000001 * steps_ + 0.8, 0.8);
-  decay *= 1.5 - ((1.0 * data->steps) / max_steps_);
-  float update = decay * learning_rate_ * (Sigmoid::Logistic(p_) - bit);
+float Mixer::LearningRate(unsigned long long* context_steps) {
+  float decay = 0.9 / portable::Pow(0.0000001 * steps_ + 0.8, 0.8);
+  decay *= 1.5 - ((1.0 * (*context_steps)) / max_steps_);
   ++steps_;
-  ++data->steps;
-  if (data->steps > max_steps_) {
-    max_steps_ = data->steps;
+  ++(*context_steps);
+  if (*context_steps > max_steps_) {
+    max_steps_ = *context_steps;
   }
+  return decay * learning_rate_;
+}
+
+void Mixer::Perceive(int bit) {
+  ContextData* data = GetContextData();
+  float update = LearningRate(&data->steps) * (Sigmoid::Logistic(p_) - bit);
   data->weights -= update * inputs_;
   if (data->steps % 1000 == 0) {
     data->weights *= 1.0 - 3.0e-6;
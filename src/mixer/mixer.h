@@ -17,15 +17,19 @@ class Mixer {
  public:
   Mixer(const std::valarray<float>& inputs, const unsigned long long& context,
       float learning_rate, unsigned long long input_size);
-  float Mix();
-  void Perceive(int bit);
+  virtual ~Mixer() {}
+  virtual float Mix();
+  virtual void Perceive(int bit);
 
- private:
-  ContextData* GetContextData();
+ protected:
+  float LearningRate(unsigned long long* context_steps);
   const std::valarray<float>& inputs_;
   float p_, learning_rate_;
   const unsigned long long& context_;
   unsigned long long max_steps_, steps_, input_size_;
+
+ private:
+  ContextData* GetContextData();
   std::unordered_map<unsigned int, std::unique_ptr<ContextData>> context_map_;
 };
 
@@ -0,0 +1,353 @@
+#ifndef PORTABLE_MATH_H
+#define PORTABLE_MATH_H
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Math functions for the floating-point paths that feed the arithmetic coder.
+// libm results can differ between machines (glibc picks FMA/non-FMA variants
+// at runtime), so these are built only from IEEE add/mul/div with a fixed
+// evaluation order. Combined with -ffp-contract=off (see the "deterministic"
+// make target) they give identical results on every x86-64 host.
+namespace portable {
+
+// Relative error < 1e-7 (Cephes expf). Inputs are clamped to [-87, 88]. The
+// body is branchless so that loops over it vectorize.
+inline float Exp(float x) {
+  x = x > 88.0f ? 88.0f : x;
+  x = x < -87.0f ? -87.0f : x;
+  // t + 128.5 is positive, so truncation rounds t to the nearest integer.
+  int k = static_cast<int>(x * 1.44269504088896341f + 128.5f) - 128;
+  float n = k;
+  x -= n * 0.693359375f;
+  x -= n * -2.12194440e-4f;
+  float p = 1.9875691500e-4f;
+  p = p * x + 1.3981999507e-3f;
+  p = p * x + 8.3334519073e-3f;
+  p = p * x + 4.1665795894e-2f;
+  p = p * x + 1.6666665459e-1f;
+  p = p * x + 5.0000001201e-1f;
+  p = p * x * x + x + 1.0f;
+  int bits = (k + 127) << 23;
+  float scale;
+  memcpy(&scale, &bits, sizeof(scale));
+  return p * scale;
+}
+
+// Relative error < 1e-7 (Cephes logf). x must be positive and normal. The
+// body is branchless so that loops over it vectorize.
+inline float Log(float x) {
+  int bits;
+  memcpy(&bits, &x, sizeof(bits));
+  int e = ((bits >> 23) & 0xff) - 127;
+  bits = (bits & 0x7fffff) | 0x3f800000;
+  float m;
+  memcpy(&m, &bits, sizeof(m));
+  // Move the mantissa from [1, 2) to [sqrt(0.5), sqrt(2)).
+  bool high = m > 1.41421356f;
+  m = high ? m * 0.5f : m;
+  e = high ? e + 1 : e;
+  float fe = e;
+  x = m - 1.0f;
+  float z = x * x;
+  float y = 7.0376836292e-2f;
+  y = y * x - 1.1514610310e-1f;
+  y = y * x + 1.1676998740e-1f;
+  y = y * x - 1.2420140846e-1f;
+  y = y * x + 1.4249322787e-1f;
+  y = y * x - 1.6668057665e-1f;
+  y = y * x + 2.0000714765e-1f;
+  y = y * x - 2.4999993993e-1f;
+  y = y * x + 3.3333331174e-1f;
+  y = y * x * z;
+  y += fe * -2.12194440e-4f;
+  y -= 0.5f * z;
+  x += y;
+  return x + fe * 0.693359375f;
+}
+
+// Relative error < 5e-16 (Cephes exp). Inputs are clamped to [-708, 709].
+inline double Exp(double x) {
+  if (x > 709.0) x = 709.0;
+  else if (x < -708.0) x = -708.0;
+  double n = floor(x * 1.4426950408889634074 + 0.5);
+  x -= n * 6.93145751953125e-1;
+  x -= n * 1.42860682030941723212e-6;
+  double xx = x * x;
+  double p = ((1.26177193074810590878e-4 * xx + 3.02994407707441961300e-2) *
+      xx + 9.99999999999999999910e-1) * x;
+  double q = ((3.00198505138664455042e-6 * xx + 2.52448340349684104192e-3) *
+      xx + 2.27265548208155028766e-1) * xx + 2.00000000000000000009e0;
+  x = 1.0 + 2.0 * (p / (q - p));
+  long long bits = (static_cast<long long>(n) + 1023) << 52;
+  double scale;
+  memcpy(&scale, &bits, sizeof(scale));
+  return x * scale;
+}
+
+// Relative error < 5e-16. x must be positive.
+inline double Log(double x) {
+  int e;
+  double m = frexp(x, &e);
+  if (m < 0.70710678118654752440) {
+    m *= 2;
+    --e;
+  }
+  double s = (m - 1) / (m + 1);
+  double s2 = s * s;
+  double t = 1.0 / 21;
+  t = t * s2 + 1.0 / 19;
+  t = t * s2 + 1.0 / 17;
+  t = t * s2 + 1.0 / 15;
+  t = t * s2 + 1.0 / 13;
+  t = t * s2 + 1.0 / 11;
+  t = t * s2 + 1.0 / 9;
+  t = t * s2 + 1.0 / 7;
+  t = t * s2 + 1.0 / 5;
+  t = t * s2 + 1.0 / 3;
+  return e * 0.69314718055994530942 + 2 * s * (1 + t * s2);
+}
+
+// base must be positive.
+inline double Pow(double base, double exponent) {
+  return Exp(exponent * Log(base));
+}
+
+// Absolute error < 2e-7.
+inline float Tanh(float x) {
+  return 1.0f - 2.0f / (Exp(2.0f * x) + 1.0f);
+}
+
+// Sums are accumulated in eight independent lanes which are combined in a
+// fixed order, so the result does not depend on the vector width the compiler
+// picks and the loop still vectorizes without -ffast-math.
+inline float CombineLanes(const float* sum) {
+  return ((sum[0] + sum[4]) + (sum[1] + sum[5])) +
+      ((sum[2] + sum[6]) + (sum[3] + sum[7]));
+}
+
+inline float DotProduct(const float* x, const float* y, int n) {
+  float sum[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    for (int j = 0; j < 8; ++j) {
+      sum[j] += x[i + j] * y[i + j];
+    }
+  }
+  for (int j = 0; i < n; ++i, ++j) {
+    sum[j] += x[i] * y[i];
+  }
+  return CombineLanes(sum);
+}
+
+// bfloat16 is the high half of a float: the same range with an 8-bit
+// significand. Conversion rounds to nearest even.
+inline unsigned short ToBfloat16(float x) {
+  unsigned int bits;
+  memcpy(&bits, &x, sizeof(bits));
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return bits >> 16;
+}
+
+inline float FromBfloat16(unsigned short x) {
+  unsigned int bits = static_cast<unsigned int>(x) << 16;
+  float y;
+  memcpy(&y, &bits, sizeof(y));
+  return y;
+}
+
+inline float DotProduct(const float* x, const unsigned short* y, int n) {
+  float sum[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    for (int j = 0; j < 8; ++j) {
+      sum[j] += x[i + j] * FromBfloat16(y[i + j]);
+    }
+  }
+  for (int j = 0; i < n; ++i, ++j) {
+    sum[j] += x[i] * FromBfloat16(y[i]);
+  }
+  return CombineLanes(sum);
+}
+
+inline float Sum(const float* x, int n) {
+  float sum[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    for (int j = 0; j < 8; ++j) {
+      sum[j] += x[i + j];
+    }
+  }
+  for (int j = 0; i < n; ++i, ++j) {
+    sum[j] += x[i];
+  }
+  return CombineLanes(sum);
+}
+
+// out[r] = DotProduct(x, matrix + r * stride, n) for each of the rows. Four
+// rows are processed per pass over x so that every load of x is shared. The
+// eight lanes of each row are kept in vector registers.
+inline void MatrixVectorProduct(const float* matrix, int stride, int rows,
+    const float* x, int n, float* out) {
+  int r = 0;
+#if defined(__AVX__)
+  for (; r + 4 <= rows; r += 4) {
+    const float* w = matrix + r * stride;
+    __m256 sum0 = _mm256_setzero_ps(), sum1 = _mm256_setzero_ps(),
+        sum2 = _mm256_setzero_ps(), sum3 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+      __m256 xi = _mm256_loadu_ps(x + i);
+      sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(xi, _mm256_loadu_ps(w + i)));
+      sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(xi,
+          _mm256_loadu_ps(w + stride + i)));
+      sum2 = _mm256_add_ps(sum2, _mm256_mul_ps(xi,
+          _mm256_loadu_ps(w + 2 * stride + i)));
+      sum3 = _mm256_add_ps(sum3, _mm256_mul_ps(xi,
+          _mm256_loadu_ps(w + 3 * stride + i)));
+    }
+    float sum[4][8];
+    _mm256_storeu_ps(sum[0], sum0);
+    _mm256_storeu_ps(sum[1], sum1);
+    _mm256_storeu_ps(sum[2], sum2);
+    _mm256_storeu_ps(sum[3], sum3);
+#elif defined(__SSE2__)
+  for (; r + 4 <= rows; r += 4) {
+    const float* w = matrix + r * stride;
+    __m128 sum0[2], sum1[2], sum2[2], sum3[2];
+    for (int j = 0; j < 2; ++j) {
+      sum0[j] = sum1[j] = sum2[j] = sum3[j] = _mm_setzero_ps();
+    }
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+      for (int j = 0; j < 2; ++j) {
+        int k = i + 4 * j;
+        __m128 xk = _mm_loadu_ps(x + k);
+        sum0[j] = _mm_add_ps(sum0[j], _mm_mul_ps(xk, _mm_loadu_ps(w + k)));
+        sum1[j] = _mm_add_ps(sum1[j], _mm_mul_ps(xk,
+            _mm_loadu_ps(w + stride + k)));
+        sum2[j] = _mm_add_ps(sum2[j], _mm_mul_ps(xk,
+            _mm_loadu_ps(w + 2 * stride + k)));
+        sum3[j] = _mm_add_ps(sum3[j], _mm_mul_ps(xk,
+            _mm_loadu_ps(w + 3 * stride + k)));
+      }
+    }
+    float sum[4][8];
+    for (int j = 0; j < 2; ++j) {
+      _mm_storeu_ps(sum[0] + 4 * j, sum0[j]);
+      _mm_storeu_ps(sum[1] + 4 * j, sum1[j]);
+      _mm_storeu_ps(sum[2] + 4 * j, sum2[j]);
+      _mm_storeu_ps(sum[3] + 4 * j, sum3[j]);
+    }
+#else
+  for (; r + 4 <= rows; r += 4) {
+    const float* w = matrix + r * stride;
+    float sum[4][8] = {{0}};
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+      for (int k = 0; k < 4; ++k) {
+        for (int j = 0; j < 8; ++j) {
+          sum[k][j] += x[i + j] * w[k * stride + i + j];
+        }
+      }
+    }
+#endif
+    for (int j = 0; i < n; ++i, ++j) {
+      for (int k = 0; k < 4; ++k) {
+        sum[k][j] += x[i] * w[k * stride + i];
+      }
+    }
+    for (int k = 0; k < 4; ++k) {
+      out[r + k] = CombineLanes(sum[k]);
+    }
+  }
+  for (; r < rows; ++r) {
+    out[r] = DotProduct(x, matrix + r * stride, n);
+  }
+}
+
+// x[i] = exp(x[i]) / sum(exp(x)) for 0 <= i < n, with n > 0. The maximum is
+// subtracted first (log-sum-exp), so no exponent is positive and the sum
+// cannot overflow.
+inline void Softmax(float* x, int n) {
+  float max = x[0];
+  for (int i = 1; i < n; ++i) {
+    max = x[i] > max ? x[i] : max;
+  }
+  for (int i = 0; i < n; ++i) {
+    x[i] = Exp(x[i] - max);
+  }
+  float sum = Sum(x, n);
+  for (int i = 0; i < n; ++i) {
+    x[i] /= sum;
+  }
+}
+
+// MatrixVectorProduct for a bfloat16 matrix, with the same summation order.
+// Products and sums are computed in single precision.
+inline void MatrixVectorProduct(const unsigned short* matrix, int stride,
+    int rows, const float* x, int n, float* out) {
+  int r = 0;
+#if defined(__SSE2__)
+  // Interleaving zeros below each bfloat16 widens it to a float.
+  const __m128i zero = _mm_setzero_si128();
+  for (; r + 4 <= rows; r += 4) {
+    const unsigned short* w = matrix + r * stride;
+    __m128 sum[4][2];
+    for (int k = 0; k < 4; ++k) {
+      sum[k][0] = sum[k][1] = _mm_setzero_ps();
+    }
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+      __m128 x0 = _mm_loadu_ps(x + i);
+      __m128 x1 = _mm_loadu_ps(x + i + 4);
+      for (int k = 0; k < 4; ++k) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+            w + k * stride + i));
+        sum[k][0] = _mm_add_ps(sum[k][0], _mm_mul_ps(x0,
+            _mm_castsi128_ps(_mm_unpacklo_epi16(zero, h))));
+        sum[k][1] = _mm_add_ps(sum[k][1], _mm_mul_ps(x1,
+            _mm_castsi128_ps(_mm_unpackhi_epi16(zero, h))));
+      }
+    }
+    float lanes[4][8];
+    for (int k = 0; k < 4; ++k) {
+      _mm_storeu_ps(lanes[k], sum[k][0]);
+      _mm_storeu_ps(lanes[k] + 4, sum[k][1]);
+    }
+#else
+  for (; r + 4 <= rows; r += 4) {
+    const unsigned short* w = matrix + r * stride;
+    float lanes[4][8] = {{0}};
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+      for (int k = 0; k < 4; ++k) {
+        for (int j = 0; j < 8; ++j) {
+          lanes[k][j] += x[i + j] * FromBfloat16(w[k * stride + i + j]);
+        }
+      }
+    }
+#endif
+    for (int j = 0; i < n; ++i, ++j) {
+      for (int k = 0; k < 4; ++k) {
+        lanes[k][j] += x[i] * FromBfloat16(w[k * stride + i]);
+      }
+    }
+    for (int k = 0; k < 4; ++k) {
+      out[r + k] = CombineLanes(lanes[k]);
+    }
+  }
+  for (; r < rows; ++r) {
+    out[r] = DotProduct(x, matrix + r * stride, n);
+  }
+}
+
+}  // namespace portable
+
+#endif
@@ -0,0 +1,111 @@
+#include "quantized-mixer.h"
+
+#include "sigmoid.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// n must be a multiple of 8. Each pair of products is shifted right by 8
+// before accumulation so that the int32 sum cannot overflow.
+int DotProduct(const short* x, const short* w, int n) {
+#if defined(__SSE2__)
+  __m128i sum = _mm_setzero_si128();
+  for (int i = 0; i < n; i += 8) {
+    __m128i tmp = _mm_madd_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i])),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&w[i])));
+    sum = _mm_add_epi32(sum, _mm_srai_epi32(tmp, 8));
+  }
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+  return _mm_cvtsi128_si32(sum);
+#else
+  int sum = 0;
+  for (int i = 0; i < n; i += 2) {
+    sum += (x[i] * w[i] + x[i + 1] * w[i + 1]) >> 8;
+  }
+  return sum;
+#endif
+}
+
+// m += x * err, saturating at +-kMasterLimit, then w = m >> 15 (rounded).
+// |x * err| < 2^30, so the int32 sum cannot overflow before the clamp.
+void Train(const short* x, int* m, short* w, int n, int err) {
+  if (err == 0) return;
+  const int kMasterLimit = 32767 << 15;
+#if defined(__SSE2__)
+  const __m128i e = _mm_set1_epi16(short(err));
+  const __m128i high = _mm_set1_epi32(kMasterLimit);
+  const __m128i low = _mm_set1_epi32(-kMasterLimit);
+  const __m128i half = _mm_set1_epi32(1 << 14);
+  for (int i = 0; i < n; i += 8) {
+    __m128i xi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i]));
+    __m128i lo = _mm_mullo_epi16(xi, e);
+    __m128i hi = _mm_mulhi_epi16(xi, e);
+    __m128i sums[2] = {_mm_unpacklo_epi16(lo, hi),
+        _mm_unpackhi_epi16(lo, hi)};
+    for (int j = 0; j < 2; ++j) {
+      __m128i* mj = reinterpret_cast<__m128i*>(&m[i + 4 * j]);
+      __m128i v = _mm_add_epi32(_mm_loadu_si128(mj), sums[j]);
+      __m128i mask = _mm_cmpgt_epi32(v, high);
+      v = _mm_or_si128(_mm_and_si128(mask, high), _mm_andnot_si128(mask, v));
+      mask = _mm_cmplt_epi32(v, low);
+      v = _mm_or_si128(_mm_and_si128(mask, low), _mm_andnot_si128(mask, v));
+      _mm_storeu_si128(mj, v);
+      sums[j] = _mm_srai_epi32(_mm_add_epi32(v, half), 15);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&w[i]),
+        _mm_packs_epi32(sums[0], sums[1]));
+  }
+#else
+  for (int i = 0; i < n; ++i) {
+    int wt = m[i] + x[i] * err;
+    if (wt < -kMasterLimit) wt = -kMasterLimit;
+    if (wt > kMasterLimit) wt = kMasterLimit;
+    m[i] = wt;
+    w[i] = (wt + (1 << 14)) >> 15;
+  }
+#endif
+}
+
+}
+
+QuantizedMixer::QuantizedMixer(const MixerInput& inputs,
+    const unsigned long long& context, float learning_rate,
+    unsigned long long input_size) : Mixer(inputs.Inputs(), context,
+    learning_rate, input_size), quantized_inputs_(inputs.QuantizedInputs()) {
+  input_size_ = (input_size + 7) & -8;
+}
+
+QuantizedContextData* QuantizedMixer::GetContextData() {
+  QuantizedContextData* data = context_map_[context_].get();
+  if (data == nullptr) {
+    context_map_[context_] = std::unique_ptr<QuantizedContextData>(
+        new QuantizedContextData(input_size_));
+    data = context_map_[context_].get();
+  }
+  return data;
+}
+
+float QuantizedMixer::Mix() {
+  QuantizedContextData* data = GetContextData();
+  int dot = DotProduct(&quantized_inputs_[0], &data->weights[0], input_size_);
+  p_ = dot * (1.0f / (1 << kWeightShift));
+  return p_;
+}
+
+void QuantizedMixer::Perceive(int bit) {
+  QuantizedContextData* data = GetContextData();
+  float update = LearningRate(&data->steps) * (Sigmoid::Logistic(p_) - bit);
+  // The weight delta is x * update, where x has 8 and the master weights
+  // have kWeightShift + 15 fractional bits.
+  float err = -update * (1 << (kWeightShift + 15 - 8));
+  if (err < -32767) err = -32767;
+  else if (err > 32767) err = 32767;
+  Train(&quantized_inputs_[0], &data->master_weights[0], &data->weights[0],
+      input_size_, err < 0 ? err - 0.5f : err + 0.5f);
+  // Unlike Mixer, no periodic weight decay is applied.
+}
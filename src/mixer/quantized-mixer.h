@@ -0,0 +1,40 @@
+#ifndef QUANTIZED_MIXER_H
+#define QUANTIZED_MIXER_H
+
+#include "mixer.h"
+#include "mixer-input.h"
+
+#include <valarray>
+#include <unordered_map>
+#include <memory>
+
+struct QuantizedContextData {
+  QuantizedContextData(unsigned long long input_size) : steps(0),
+      weights(input_size), master_weights(input_size) {};
+  unsigned long long steps;
+  std::valarray<short> weights;
+  std::valarray<int> master_weights;
+};
+
+// Fixed-point variant of Mixer. Inputs are 8.8 fixed-point stretched
+// probabilities, weights are int16 with kWeightShift fractional bits and the
+// dot product is accumulated in int32 (like the PAQ8 mixer). Updates go to
+// int32 master weights with 15 more fractional bits, so that the small steps
+// of the learning rate schedule of Mixer are not rounded away, and the int16
+// weights are their rounded high halves.
+class QuantizedMixer : public Mixer {
+ public:
+  static const int kWeightShift = 13;
+  QuantizedMixer(const MixerInput& inputs, const unsigned long long& context,
+      float learning_rate, unsigned long long input_size);
+  float Mix();
+  void Perceive(int bit);
+
+ private:
+  QuantizedContextData* GetContextData();
+  const std::valarray<short>& quantized_inputs_;
+  std::unordered_map<unsigned int, std::unique_ptr<QuantizedContextData>>
+      context_map_;
+};
+
+#endif
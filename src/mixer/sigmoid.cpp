@@ -1,22 +1,19 @@
 #include "sigmoid.h"
 
-#include <math.h>
-
-Sigmoid::Sigmoid(int logit_size) : logit_size_(logit_size),
-    logit_table_(logit_size, 0) {
-  for (int i = 0; i < logit_size_; ++i) {
-    logit_table_[i] = SlowLogit((i + 0.5) / logit_size_);
+void Sigmoid::Logit(const float* in, float* out, int n) {
+  for (int i = 0; i < n; ++i) {
+    out[i] = Logit(in[i]);
   }
 }
 
-float Sigmoid::Logit(float p) const {
-  return logit_table_[p * logit_size_];
-}
-
-float Sigmoid::Logistic(float p) {
-  return 1 / (1 + exp(-p));
+void Sigmoid::Logistic(const float* in, float* out, int n) {
+  for (int i = 0; i < n; ++i) {
+    out[i] = Logistic(in[i]);
+  }
 }
 
-float Sigmoid::SlowLogit(float p) {
-  return log(p / (1 - p));
+void Sigmoid::Tanh(const float* in, float* out, int n) {
+  for (int i = 0; i < n; ++i) {
+    out[i] = Tanh(in[i]);
+  }
 }
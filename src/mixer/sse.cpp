@@ -2,6 +2,7 @@
 // https://encode.ru/threads/2515-mod_ppmd
 
 #include "sse.h"
+#include "portable-math.h"
 
 #include <math.h>
 
@@ -75,9 +76,9 @@ enum {
 #define M_LOG2E 1.44269504088896340736
 #endif
 
-double log2( double a ) { return M_LOG2E*log(a); }
+double log2( double a ) { return M_LOG2E*portable::Log(a); }
 
-double exp2( double a ) { return exp( a/M_LOG2E ); }
+double exp2( double a ) { return portable::Exp( a/M_LOG2E ); }
 
 double st( double p ) { return log2((1-p)/p); }
 
@@ -0,0 +1,65 @@
+#include "thread-pool.h"
+
+ThreadPool::ThreadPool(unsigned int num_threads) :
+    num_threads_(num_threads < 1 ? 1 : num_threads), task_(nullptr),
+    size_(0), pending_(0), generation_(0), stop_(false) {
+  for (unsigned int i = 1; i < num_threads_; ++i) {
+    threads_.push_back(std::thread(&ThreadPool::Work, this, i));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPool::RunShare(unsigned int thread) {
+  unsigned long long size = size_;
+  unsigned int begin = size * thread / num_threads_;
+  unsigned int end = size * (thread + 1) / num_threads_;
+  if (begin < end) (*task_)(thread, begin, end);
+}
+
+void ThreadPool::Run(unsigned int size, const Task& task) {
+  if (num_threads_ == 1) {
+    if (size > 0) task(0, 0, size);
+    return;
+  }
+  std::lock_guard<std::mutex> run_lock(run_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    size_ = size;
+    pending_ = num_threads_ - 1;
+    ++generation_;
+  }
+  start_.notify_all();
+  RunShare(0);
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] {return pending_ == 0;});
+}
+
+void ThreadPool::Work(unsigned int thread) {
+  unsigned long long generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock, [&] {return stop_ || generation_ != generation;});
+      if (stop_) return;
+      generation = generation_;
+    }
+    RunShare(thread);
+    bool last = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      last = (--pending_ == 0);
+    }
+    if (last) done_.notify_one();
+  }
+}
@@ -0,0 +1,44 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Splits a range of work items between a fixed set of threads. Each thread
+// always gets the same contiguous share of a given range, so callers can keep
+// their results independent of the thread count by making every item's output
+// depend only on that item. With one thread no threads are started and the
+// work runs on the calling thread.
+class ThreadPool {
+ public:
+  typedef std::function<void(unsigned int thread, unsigned int begin,
+      unsigned int end)> Task;
+
+  explicit ThreadPool(unsigned int num_threads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  unsigned int NumThreads() const {return num_threads_;}
+  // Calls task(thread, begin, end) for the share of [0, size) of each thread
+  // and returns once all of them are done. The calling thread runs share 0.
+  // Calls from different threads are run one at a time.
+  void Run(unsigned int size, const Task& task);
+
+ private:
+  void Work(unsigned int thread);
+  void RunShare(unsigned int thread);
+
+  unsigned int num_threads_;
+  std::vector<std::thread> threads_;
+  std::mutex run_mutex_, mutex_;
+  std::condition_variable start_, done_;
+  const Task* task_;
+  unsigned int size_, pending_;
+  unsigned long long generation_;
+  bool stop_;
+};
+
+#endif
@@ -3,57 +3,43 @@
 Bracket::Bracket(const unsigned int& bit_context, int distance_limit,
     int stack_limit, int stats_limit, const std::vector<bool>& vocab) :
     ByteModel(vocab), distance_limit_(distance_limit),
-    stack_limit_(stack_limit), stats_limit_(stats_limit), byte_(bit_context),
-    stats_(256, std::vector<std::pair<unsigned int, unsigned int>>
-    (distance_limit_, {1, 256})) {
-  brackets_ = {{'(',')'}, {'{','}'}, {'[',']'}, {'<','>'}, {'\'','\''},
-      {'"','"'}};
+    stats_limit_(stats_limit), byte_(bit_context),
+    stack_("(){}[]<>''\"\"", stack_limit),
+    stats_(256 * distance_limit_, {1, 256}) {}
+
+void Bracket::PredictCloser(unsigned char bracket, unsigned int distance) {
+  const auto& stats = stats_[bracket * distance_limit_ + distance];
+  float p = (1. * stats.first) / stats.second;
+  SetFloor((1 - p) / 255);
+  AddSpike(stack_.Closer(bracket), p);
 }
 
 void Bracket::ByteUpdate() {
-  probs_ = 1./256;
-  if (active_.empty() || (brackets_.find(byte_) != brackets_.end() &&
-      !(active_[active_.size() - 1] == byte_ && brackets_[byte_] == byte_))) {
-    if (brackets_.find(byte_) != brackets_.end()) {
-      active_.push_back(byte_);
-      distance_.push_back(0);
-      if (active_.size() > stack_limit_) {
-        active_.erase(active_.begin());
-        distance_.erase(distance_.begin());
-      }
-      float p = (1. * stats_[byte_][0].first) / stats_[byte_][0].second;
-      probs_ = (1 - p) / 255;
-      probs_[brackets_[byte_]] = p;
+  SetFloor(1./256);
+  unsigned char closer = stack_.Closer(byte_);
+  if (stack_.Empty() || (closer != 0 &&
+      !(stack_.Top() == byte_ && closer == byte_))) {
+    if (closer != 0) {
+      stack_.Push(byte_);
+      PredictCloser(byte_, 0);
     }
   } else {
-    unsigned int active = active_[active_.size() - 1];
-    unsigned int distance = distance_[distance_.size() - 1];
-    ++stats_[active][distance].second;
-    if (brackets_[active] == byte_) {
-      ++stats_[active][distance].first;
-    }
-    if (stats_[active][distance].second > stats_limit_) {
-      stats_[active][distance].first /= 2;
-      stats_[active][distance].second /= 2;
+    unsigned char active = stack_.Top();
+    unsigned int distance = stack_.Distance();
+    auto& stats = stats_[active * distance_limit_ + distance];
+    bool closed = stack_.Closer(active) == byte_;
+    ++stats.second;
+    if (closed) ++stats.first;
+    if (stats.second > stats_limit_) {
+      stats.first /= 2;
+      stats.second /= 2;
     }
-    if (brackets_[active] == byte_ || distance >= distance_limit_ - 1) {
-      active_.pop_back();
-      distance_.pop_back();
-      if (!active_.empty()) {
-        int active = active_[active_.size() - 1];
-        int distance = distance_[distance_.size() - 1];
-        float p = (1. * stats_[active][distance].first) /
-            stats_[active][distance].second;
-        probs_ = (1 - p) / 255;
-        probs_[brackets_[active]] = p;
-      }
+    if (closed || distance >= distance_limit_ - 1) {
+      stack_.Pop();
+      if (!stack_.Empty()) PredictCloser(stack_.Top(), stack_.Distance());
     } else {
-      ++distance_[distance_.size() - 1];
-      ++distance;
-      float p = (1. * stats_[active][distance].first) /
-          stats_[active][distance].second;
-      probs_ = (1 - p) / 255;
-      probs_[brackets_[active]] = p;
+      stack_.Advance();
+      PredictCloser(active, distance + 1);
     }
   }
   ByteModel::ByteUpdate();
@@ -2,8 +2,8 @@
 #define BRACKET_H
 
 #include "byte-model.h"
+#include "../contexts/bracket-stack.h"
 
-#include <unordered_map>
 #include <vector>
 #include <utility>
 
@@ -14,11 +14,14 @@ class Bracket : public ByteModel {
   void ByteUpdate();
 
  private:
-  std::unordered_map<unsigned char, unsigned char> brackets_;
-  unsigned int distance_limit_, stack_limit_, stats_limit_;
-  std::vector<unsigned int> active_, distance_;
+  void PredictCloser(unsigned char bracket, unsigned int distance);
+
+  unsigned int distance_limit_, stats_limit_;
   const unsigned int& byte_;
-  std::vector<std::vector<std::pair<unsigned int, unsigned int>>> stats_;
+  BracketStack stack_;
+  // How often each (bracket, distance) was followed by the closing bracket,
+  // out of how many times it was seen.
+  std::vector<std::pair<unsigned int, unsigned int>> stats_;
 };
 
 #endif
@@ -1,34 +1,89 @@
 #include "byte-model.h"
 
-#include <numeric>
+ByteModel::ByteModel(const std::vector<bool>& vocab) : vocab_(vocab),
+    probs_(1.0 / 256, 256), node_(1), sparse_(false), floor_(0),
+    sums_(0.0f, 512), counts_(512, 0) {
+  for (int i = 0; i < 256; ++i) {
+    counts_[256 + i] = vocab_[i];
+  }
+  for (int i = 255; i >= 1; --i) {
+    counts_[i] = counts_[2 * i] + counts_[2 * i + 1];
+  }
+}
+
+void ByteModel::SetFloor(float floor) {
+  sparse_ = true;
+  floor_ = floor;
+  spikes_.clear();
+}
+
+void ByteModel::AddSpike(unsigned char byte, float p) {
+  spikes_.push_back(std::make_pair(byte, p));
+}
 
-ByteModel::ByteModel(const std::vector<bool>& vocab) : top_(255), mid_(0),
-    bot_(0), vocab_(vocab), probs_(1.0 / 256, 256) {}
+float ByteModel::SparseSum(int node) const {
+  float sum = floor_ * counts_[node];
+  int shift = 8 - (31 - __builtin_clz(node));
+  for (const auto& spike : spikes_) {
+    if ((256 + spike.first) >> shift == node) sum += spike.second - floor_;
+  }
+  return sum;
+}
 
 const std::valarray<float>& ByteModel::Predict() {
-  mid_ = bot_ + ((top_ - bot_) / 2);
-  float num = std::accumulate(&probs_[mid_ + 1], &probs_[top_ + 1], 0.0f);
-  float denom = std::accumulate(&probs_[bot_], &probs_[mid_ + 1], num);
+  float num, denom;
+  if (sparse_) {
+    num = SparseSum(2 * node_ + 1);
+    denom = SparseSum(2 * node_);
+  } else {
+    if (node_ == 1) {
+      // probs_ only changes between bytes.
+      for (int i = 0; i < 256; ++i) {
+        sums_[256 + i] = probs_[i];
+      }
+      for (int i = 255; i >= 1; --i) {
+        sums_[i] = sums_[2 * i] + sums_[2 * i + 1];
+      }
+    }
+    num = sums_[2 * node_ + 1];
+    denom = sums_[2 * node_];
+  }
+  denom += num;
   if (denom == 0) outputs_[0] = 0.5;
   else outputs_[0] = num / denom;
   return outputs_;
 }
 
 const std::valarray<float>& ByteModel::BytePredict() {
+  if (sparse_) {
+    for (int i = 0; i < 256; ++i) {
+      probs_[i] = counts_[256 + i] * floor_;
+    }
+    for (const auto& spike : spikes_) {
+      probs_[spike.first] = spike.second;
+    }
+  }
   return probs_;
 }
 
 void ByteModel::Perceive(int bit) {
-  if (bit) {
-    bot_ = mid_ + 1;
-  } else {
-    top_ = mid_;
-  }
+  node_ = 2 * node_ + bit;
 }
 
 void ByteModel::ByteUpdate() {
-  top_ = 255;
-  bot_ = 0;
+  node_ = 1;
+  if (sparse_) {
+    unsigned int i = 0;
+    while (i < spikes_.size()) {
+      if (vocab_[spikes_[i].first]) {
+        ++i;
+      } else {
+        spikes_[i] = spikes_.back();
+        spikes_.pop_back();
+      }
+    }
+    return;
+  }
   for (int i = 0; i < 256; ++i) {
     if (!vocab_[i]) probs_[i] = 0;
   }
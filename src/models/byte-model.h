@@ -3,22 +3,48 @@
 
 #include "model.h"
 
+#include <utility>
 #include <valarray>
 #include <vector>
 
+// A model that predicts a distribution over the next byte. In ByteUpdate(),
+// subclasses either fill probs_ or describe a sparse distribution with
+// SetFloor() and AddSpike(). The bit predictions come from a tree of partial
+// sums built once per byte, or directly from the sparse form.
 class ByteModel : public Model {
  public:
   virtual ~ByteModel() {}
   ByteModel(const std::vector<bool>& vocab);
   const std::valarray<float>& BytePredict();
+  // Sparse form: Floor() for every byte in the vocabulary except the Spikes().
+  bool IsSparse() const { return sparse_; }
+  float Floor() const { return floor_; }
+  const std::vector<std::pair<unsigned char, float>>& Spikes() const {
+    return spikes_;
+  }
   const std::valarray<float>& Predict();
   void Perceive(int bit);
   virtual void ByteUpdate();
 
  protected:
-  int top_, mid_, bot_;
+  void SetFloor(float floor);
+  void AddSpike(unsigned char byte, float p);
+
   const std::vector<bool>& vocab_;
   std::valarray<float> probs_;
+
+ private:
+  // Node n of the tree is the current partial byte: sums_[n] is the total
+  // probability of the bytes that start with it.
+  float SparseSum(int node) const;
+
+  int node_;
+  bool sparse_;
+  float floor_;
+  std::vector<std::pair<unsigned char, float>> spikes_;
+  std::valarray<float> sums_;
+  // Number of vocabulary bytes that start with each node.
+  std::vector<int> counts_;
 };
 
 #endif
@@ -0,0 +1,67 @@
+#include "byte-run-bank.h"
+
+ByteRunBank::ByteRunBank(const unsigned int& bit_context) : Model(0),
+    bit_context_(bit_context), bit_pos_(128) {}
+
+void ByteRunBank::Add(const unsigned long long& byte_context, float delta,
+    unsigned long long map_size) {
+  byte_contexts_.push_back(&byte_context);
+  byte_prediction_.push_back(0);
+  run_length_.push_back(0);
+  map_index_.push_back(0);
+  divisor_.push_back(1.0 / delta);
+  map_.push_back(std::vector<unsigned char>(map_size, 0));
+  counts_.push_back(std::vector<unsigned char>(map_size, 0));
+  for (int i = 0; i < 256; ++i) {
+    predictions_.push_back(0.5 + ((i + 0.5) / 512));
+  }
+  outputs_.resize(byte_contexts_.size(), 0.5);
+}
+
+const std::valarray<float>& ByteRunBank::Predict() {
+  if (bit_pos_ == 128) {
+    for (unsigned int i = 0; i < outputs_.size(); ++i) {
+      byte_prediction_[i] = map_[i][map_index_[i]];
+      run_length_[i] = counts_[i][map_index_[i]];
+    }
+  }
+  for (unsigned int i = 0; i < outputs_.size(); ++i) {
+    float p = predictions_[i * 256 + run_length_[i]];
+    if (byte_prediction_[i] & bit_pos_) outputs_[i] = p;
+    else outputs_[i] = 1 - p;
+  }
+  return outputs_;
+}
+
+void ByteRunBank::Perceive(int bit) {
+  for (unsigned int i = 0; i < outputs_.size(); ++i) {
+    int match = 0;
+    if (((byte_prediction_[i] & bit_pos_) != 0) == bit) match = 1;
+    float& p = predictions_[i * 256 + run_length_[i]];
+    p += (match - p) * divisor_[i];
+    if (match == 0) run_length_[i] = 0;
+  }
+  bit_pos_ /= 2;
+
+  if (bit_context_ >= 128) {
+    unsigned char byte = (bit_context_ << 1) + bit;
+    for (unsigned int i = 0; i < outputs_.size(); ++i) {
+      unsigned char& count = counts_[i][map_index_[i]];
+      if (byte == byte_prediction_[i]) {
+        if (count < 255) ++count;
+      } else {
+        map_[i][map_index_[i]] = byte;
+        count = 0;
+      }
+    }
+  }
+}
+
+void ByteRunBank::ByteUpdate() {
+  for (unsigned int i = 0; i < outputs_.size(); ++i) {
+    map_index_[i] = *byte_contexts_[i] % map_[i].size();
+    __builtin_prefetch(&map_[i][map_index_[i]]);
+    __builtin_prefetch(&counts_[i][map_index_[i]]);
+  }
+  bit_pos_ = 128;
+}
@@ -0,0 +1,32 @@
+#ifndef BYTE_RUN_BANK_H
+#define BYTE_RUN_BANK_H
+
+#include "model.h"
+
+#include <vector>
+
+// All byte run models: each predicts the byte that last followed its byte
+// context, with a confidence that depends on how often that byte has repeated.
+// Per-model data is kept in parallel arrays and all models are updated in one
+// loop. Outputs are in the order of Add() calls.
+class ByteRunBank : public Model {
+ public:
+  ByteRunBank(const unsigned int& bit_context);
+  void Add(const unsigned long long& byte_context, float delta,
+      unsigned long long map_size);
+  const std::valarray<float>& Predict();
+  void Perceive(int bit);
+  void ByteUpdate();
+
+ private:
+  const unsigned int& bit_context_;
+  unsigned char bit_pos_;
+  std::vector<const unsigned long long*> byte_contexts_;
+  std::vector<unsigned char> byte_prediction_, run_length_;
+  std::vector<unsigned int> map_index_;
+  std::vector<float> divisor_;
+  std::vector<std::vector<unsigned char>> map_, counts_;
+  std::vector<float> predictions_;
+};
+
+#endif
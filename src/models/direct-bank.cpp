@@ -0,0 +1,158 @@
+#include "direct-bank.h"
+
+#include <algorithm>
+
+namespace {
+
+const float kScale = 65536, kInverseScale = 1.0 / 65536;
+
+unsigned long long Hash(unsigned long long context) {
+  return (context + 1) * 0x9E3779B97F4A7C15ULL;
+}
+
+}
+
+DirectBank::Table::Table(unsigned long long num_slots, bool hashed) :
+    num_buckets(0), hashed(hashed) {
+  size = num_slots;
+  if (hashed) {
+    num_buckets = (num_slots + kWays - 1) / kWays;
+    size = num_buckets * kWays;
+  }
+  // Groups and buckets are aligned to cache lines.
+  unsigned long long bucket_bytes = (num_buckets + 1) / 2 * 64;
+  storage.resize(64 + bucket_bytes + size * kGroupsPerSlot * sizeof(Group), 0);
+  unsigned long long address = reinterpret_cast<unsigned long long>(
+      storage.data());
+  unsigned char* start = storage.data() + (-address % 64);
+  buckets = reinterpret_cast<Bucket*>(start);
+  groups = reinterpret_cast<Group*>(start + bucket_bytes);
+  for (unsigned long long i = 0; i < size; ++i) {
+    Reset(i);
+  }
+}
+
+void DirectBank::Table::Reset(unsigned long long index) {
+  Group* slot = Slot(index);
+  for (int i = 0; i < kGroupsPerSlot; ++i) {
+    std::fill_n(slot[i].predictions, 16, kScale / 2);
+    std::fill_n(slot[i].counts, 16, 0);
+  }
+}
+
+DirectBank::DirectBank(const unsigned int& bit_context) : Model(0),
+    bit_context_(bit_context) {
+  for (int i = 1; i < 256; ++i) {
+    int bits = 0;
+    while ((i >> bits) > 1) ++bits;
+    if (bits < 4) {
+      group_[i] = 0;
+      entry_[i] = i;
+    } else {
+      group_[i] = 1 + ((i >> (bits - 4)) & 15);
+      entry_[i] = (1 << (bits - 4)) | (i & ((1 << (bits - 4)) - 1));
+    }
+  }
+  group_[0] = entry_[0] = 0;
+}
+
+void DirectBank::AddModel(const unsigned long long& byte_context, int limit,
+    float delta, int size, bool hashed) {
+  std::unique_ptr<Table> table(new Table(size, hashed));
+  byte_contexts_.push_back(&byte_context);
+  index_.push_back(0);
+  checksums_.push_back(0);
+  limit_.push_back(limit);
+  delta_.push_back(delta);
+  divisor_.push_back(1.0 / (limit + delta));
+  slots_.push_back(table->Slot(0));
+  tables_.push_back(std::move(table));
+  outputs_.resize(byte_contexts_.size(), 0.5);
+}
+
+void DirectBank::Add(const unsigned long long& byte_context, int limit,
+    float delta, int size) {
+  AddModel(byte_context, limit, delta, size, false);
+}
+
+void DirectBank::AddHashed(const unsigned long long& byte_context, int limit,
+    float delta, int size) {
+  AddModel(byte_context, limit, delta, size, true);
+}
+
+const std::valarray<float>& DirectBank::Predict() {
+  if (bit_context_ == 1) {
+    for (unsigned int i = 0; i < outputs_.size(); ++i) {
+      Table& table = *tables_[i];
+      slots_[i] = table.Slot(table.hashed ? Lookup(i) : index_[i]);
+    }
+  }
+  int group = group_[bit_context_], entry = entry_[bit_context_];
+  for (unsigned int i = 0; i < outputs_.size(); ++i) {
+    outputs_[i] = slots_[i][group].predictions[entry] * kInverseScale;
+  }
+  return outputs_;
+}
+
+void DirectBank::Perceive(int bit) {
+  int group = group_[bit_context_], entry = entry_[bit_context_];
+  for (unsigned int i = 0; i < outputs_.size(); ++i) {
+    unsigned char& count = slots_[i][group].counts[entry];
+    unsigned short& prediction = slots_[i][group].predictions[entry];
+    float divisor = divisor_[i];
+    if (count < limit_[i]) {
+      ++count;
+      divisor = 1.0 / (count + delta_[i]);
+    }
+    float p = prediction * kInverseScale;
+    p += (bit - p) * divisor;
+    prediction = std::min(p * kScale + 0.5f, kScale - 1);
+  }
+  if (bit_context_ >= 8 && bit_context_ < 16) {
+    // The first nibble is known, so the group of the second one is too.
+    group = group_[bit_context_ * 2 + bit];
+    for (unsigned int i = 0; i < outputs_.size(); ++i) {
+      __builtin_prefetch(slots_[i] + group);
+    }
+  }
+}
+
+void DirectBank::ByteUpdate() {
+  for (unsigned int i = 0; i < outputs_.size(); ++i) {
+    Table& table = *tables_[i];
+    if (table.hashed) {
+      unsigned long long hash = Hash(*byte_contexts_[i]);
+      // Range reduction by multiplication instead of a 64-bit modulo. Bits
+      // 16-47 pick the bucket and the top 16 bits are the checksum.
+      index_[i] = (((hash >> 16) & 0xFFFFFFFF) * table.num_buckets) >> 32;
+      checksums_[i] = hash >> 48;
+      __builtin_prefetch(&table.buckets[index_[i]]);
+    } else {
+      index_[i] = *byte_contexts_[i];
+      __builtin_prefetch(table.Slot(index_[i]));
+    }
+  }
+}
+
+unsigned long long DirectBank::Lookup(unsigned int i) {
+  Table& table = *tables_[i];
+  Bucket& bucket = table.buckets[index_[i]];
+  unsigned long long first = index_[i] * kWays;
+  int way = 0;
+  for (int j = 0; j < kWays; ++j) {
+    if (bucket.uses[j] != 0 && bucket.checksums[j] == checksums_[i]) {
+      if (bucket.uses[j] < 255) ++bucket.uses[j];
+      return first + j;
+    }
+    if (bucket.uses[j] < bucket.uses[way]) way = j;
+  }
+  // Age the other contexts, so that ones which were only used long ago can
+  // be replaced eventually. A used slot never decays to 0.
+  for (int j = 0; j < kWays; ++j) {
+    bucket.uses[j] -= bucket.uses[j] >> 1;
+  }
+  table.Reset(first + way);
+  bucket.checksums[way] = checksums_[i];
+  bucket.uses[way] = 1;
+  return first + way;
+}
@@ -0,0 +1,82 @@
+#ifndef DIRECT_BANK_H
+#define DIRECT_BANK_H
+
+#include "model.h"
+
+#include <vector>
+#include <memory>
+
+// All direct models: each keeps an adaptive probability and count per
+// (byte context, bit context) pair. AddHashed() models map the byte context to
+// a bucket of kWays slots, which is searched for a 16-bit checksum. On a miss
+// the slot of the least used context in the bucket is replaced and the use
+// counts of the others are halved.
+// Per-model data is kept in parallel arrays and all models are updated in one
+// loop. Outputs are in the order of Add()/AddHashed() calls.
+//
+// A slot holds the 255 bit nodes of one byte context in 17 cache-line sized
+// groups: group 0 for the first nibble, group 1 + h for the second nibble
+// after first nibble h. Coding a byte touches two cache lines per model; the
+// second is prefetched as soon as the first nibble is known, before the rest
+// of the models perceive the fourth bit.
+class DirectBank : public Model {
+ public:
+  DirectBank(const unsigned int& bit_context);
+  void Add(const unsigned long long& byte_context, int limit, float delta,
+      int size);
+  void AddHashed(const unsigned long long& byte_context, int limit,
+      float delta, int size);
+  const std::valarray<float>& Predict();
+  void Perceive(int bit);
+  void ByteUpdate();
+
+ private:
+  // Probabilities are 16-bit fixed point. Node k of a nibble (1 <= k < 16,
+  // the bits seen so far in the nibble with a leading 1) is entry k.
+  struct Group {
+    unsigned short predictions[16];
+    unsigned char counts[16];
+    unsigned char padding[16];
+  };
+  static const int kGroupsPerSlot = 17;
+  // The checksums of the contexts in the slots of a hashed bucket, and how
+  // often each was seen (saturating and halved on every miss in the bucket,
+  // 0 only for an empty slot). Two buckets share a cache line.
+  static const int kWays = 7;
+  struct Bucket {
+    unsigned short checksums[kWays];
+    unsigned char uses[kWays];
+    unsigned char padding[11];
+  };
+  struct Table {
+    Table(unsigned long long num_slots, bool hashed);
+    Group* Slot(unsigned long long index) {
+      return groups + index * kGroupsPerSlot;
+    }
+    void Reset(unsigned long long index);
+    std::vector<unsigned char> storage;
+    Group* groups;
+    Bucket* buckets;
+    unsigned long long size, num_buckets;
+    bool hashed;
+  };
+  void AddModel(const unsigned long long& byte_context, int limit, float delta,
+      int size, bool hashed);
+  // Returns the slot of hashed model i, replacing one if needed.
+  unsigned long long Lookup(unsigned int i);
+
+  const unsigned int& bit_context_;
+  std::vector<const unsigned long long*> byte_contexts_;
+  // The slot of each model, or the bucket for hashed models.
+  std::vector<unsigned long long> index_;
+  std::vector<unsigned short> checksums_;
+  std::vector<int> limit_;
+  std::vector<float> delta_, divisor_;
+  // Group 0 of the slot of each model for the current byte, and the group and
+  // entry of each bit context.
+  std::vector<Group*> slots_;
+  unsigned char group_[256], entry_[256];
+  std::vector<std::unique_ptr<Table>> tables_;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "indirect-bank.h"
+#include <stdlib.h>
+#include <string.h>
+
+IndirectBank::IndirectBank(const unsigned int& bit_context,
+    std::vector<unsigned char>& map) : Model(0), bit_context_(bit_context),
+    map_(map), nibble_(1), round_(0), lookup_(true) {
+  unsigned long long skew = (64 - (unsigned long long)&map_[0] % 64) % 64;
+  lines_ = reinterpret_cast<Line*>(&map_[skew]);
+  num_lines_ = (map_.size() - skew) / sizeof(Line);
+}
+
+void IndirectBank::Add(const State& state,
+    const unsigned long long& byte_context, float delta) {
+  unsigned int transition_index = 0;
+  while (transition_index < states_.size() &&
+      states_[transition_index] != &state) {
+    ++transition_index;
+  }
+  if (transition_index == states_.size()) {
+    states_.push_back(&state);
+    transitions_.push_back(std::array<unsigned char, 512>());
+    for (int i = 0; i < 512; ++i) {
+      transitions_[transition_index][i] = state.Next(i / 2, i % 2);
+    }
+  }
+  byte_contexts_.push_back(&byte_context);
+  seed_.push_back(rand());
+  line_.push_back(0);
+  checksum_.push_back(0);
+  slot_.push_back(nullptr);
+  scratch_.push_back(std::array<unsigned char, 16>());
+  divisor_.push_back(1.0 / delta);
+  transition_index_.push_back(transition_index);
+  for (int i = 0; i < 256; ++i) {
+    predictions_.push_back(state.InitProbability(i));
+  }
+  outputs_.resize(byte_contexts_.size(), 0.5);
+  Hash(outputs_.size() - 1, 1);
+}
+
+void IndirectBank::Hash(unsigned int i, unsigned int nibble_context) {
+  unsigned long long hash = (*byte_contexts_[i] + 1) * 0x9E3779B97F4A7C15ULL;
+  hash ^= (seed_[i] * 32 + nibble_context) * 0xC2B2AE3D27D4EB4FULL;
+  hash ^= hash >> 29;
+  hash *= 0x9E3779B97F4A7C15ULL;
+  hash ^= hash >> 32;
+  // Range reduction by multiplication instead of a 64-bit modulo.
+  line_[i] = ((hash >> 32) * num_lines_) >> 32;
+  checksum_[i] = hash;
+  __builtin_prefetch(lines_ + line_[i]);
+}
+
+void IndirectBank::Lookup(unsigned int i) {
+  Line& line = lines_[line_[i]];
+  int way = 0;
+  for (int j = 0; j < kWays; ++j) {
+    if (line.checksums[j] == checksum_[i]) {
+      way = j;
+      break;
+    }
+    if (line.ages[j] > line.ages[way]) way = j;
+  }
+  if (line.checksums[way] != checksum_[i]) {
+    // Every lookup ages the slots it does not use, so the oldest slot was
+    // only handed out in this round if all of them were.
+    if (line.rounds[way] == round_) {
+      scratch_[i].fill(0);
+      slot_[i] = scratch_[i].data();
+      return;
+    }
+    line.checksums[way] = checksum_[i];
+    memset(line.states[way], 0, sizeof(line.states[way]));
+  }
+  for (int j = 0; j < kWays; ++j) {
+    if (line.ages[j] < 255) ++line.ages[j];
+  }
+  line.ages[way] = 0;
+  line.rounds[way] = round_;
+  slot_[i] = line.states[way];
+}
+
+const std::valarray<float>& IndirectBank::Predict() {
+  if (lookup_) {
+    // Round 0 is skipped: it is the stamp of a line that was never used.
+    if (++round_ == 0) round_ = 1;
+    for (unsigned int i = 0; i < outputs_.size(); ++i) {
+      Lookup(i);
+    }
+    lookup_ = false;
+  }
+  for (unsigned int i = 0; i < outputs_.size(); ++i) {
+    int state = slot_[i][nibble_];
+    outputs_[i] = predictions_[i * 256 + state];
+  }
+  return outputs_;
+}
+
+void IndirectBank::Perceive(int bit) {
+  for (unsigned int i = 0; i < outputs_.size(); ++i) {
+    unsigned char& slot = slot_[i][nibble_];
+    int state = slot;
+    float& p = predictions_[i * 256 + state];
+    p += (bit - p) * divisor_[i];
+    slot = transitions_[transition_index_[i]][state * 2 + bit];
+  }
+  nibble_ = nibble_ * 2 + bit;
+  if (nibble_ < 16) return;
+  nibble_ = 1;
+  if (bit_context_ >= 16) return;
+  // The first nibble is known: find the slot for the second one.
+  for (unsigned int i = 0; i < outputs_.size(); ++i) {
+    Hash(i, bit_context_ * 2 + bit);
+  }
+  lookup_ = true;
+}
+
+void IndirectBank::ByteUpdate() {
+  for (unsigned int i = 0; i < outputs_.size(); ++i) {
+    Hash(i, 1);
+  }
+  lookup_ = true;
+}
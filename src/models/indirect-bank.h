@@ -0,0 +1,65 @@
+#ifndef INDIRECT_BANK_H
+#define INDIRECT_BANK_H
+
+#include "model.h"
+#include "../states/state.h"
+
+#include <vector>
+#include <array>
+
+// All indirect models: each hashes its byte context (and the first nibble, for
+// the second half of the byte) to a 64-byte line of the shared map. A line is
+// a bucket of kWays slots, each holding the 15 bit-history states of a nibble,
+// with a 16-bit checksum and an age per slot. A miss replaces the least
+// recently used slot, unless that slot was already handed to another model at
+// the same nibble: the model then works on a private scratch slot for that
+// nibble instead. Every state has an adaptive probability per model.
+// Per-model data is kept in parallel arrays and all models are updated in one
+// loop. Outputs are in the order of Add() calls.
+class IndirectBank : public Model {
+ public:
+  IndirectBank(const unsigned int& bit_context,
+      std::vector<unsigned char>& map);
+  void Add(const State& state, const unsigned long long& byte_context,
+      float delta);
+  const std::valarray<float>& Predict();
+  void Perceive(int bit);
+  void ByteUpdate();
+
+ private:
+  static const int kWays = 3;
+  // Slots do not move within a line and are not replaced while in use, so a
+  // model's slot stays valid while other models look up the same line.
+  // rounds holds the lookup round in which each slot was last handed out.
+  // Node k of the nibble is states[k].
+  struct Line {
+    unsigned short checksums[kWays];
+    unsigned short rounds[kWays];
+    unsigned char ages[kWays];
+    unsigned char padding[1];
+    unsigned char states[kWays][16];
+  };
+  void Hash(unsigned int i, unsigned int nibble_context);
+  void Lookup(unsigned int i);
+
+  const unsigned int& bit_context_;
+  std::vector<unsigned char>& map_;
+  Line* lines_;
+  unsigned long long num_lines_;
+  unsigned int nibble_;
+  unsigned short round_;
+  bool lookup_;
+  std::vector<const unsigned long long*> byte_contexts_;
+  std::vector<unsigned long long> seed_, line_;
+  std::vector<unsigned short> checksum_;
+  std::vector<unsigned char*> slot_;
+  std::vector<std::array<unsigned char, 16>> scratch_;
+  std::vector<float> divisor_;
+  std::vector<unsigned int> transition_index_;
+  std::vector<float> predictions_;
+  // Next-state table (state * 2 + bit) for each distinct State.
+  std::vector<const State*> states_;
+  std::vector<std::array<unsigned char, 512>> transitions_;
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "match-bank.h"
+
+MatchBank::MatchBank(const std::vector<unsigned char>& history,
+    const unsigned int& bit_context, unsigned long long* longest_match) :
+    Model(0), history_(history), bit_context_(bit_context),
+    longest_match_(longest_match), history_pos_(0), bit_pos_(128),
+    requested_size_(0), table_bits_(0) {}
+
+void MatchBank::Add(const unsigned long long& byte_context, int limit,
+    float delta, unsigned long long map_size) {
+  byte_contexts_.push_back(&byte_context);
+  cur_match_.push_back(0);
+  table_index_.push_back(0);
+  checksum_.push_back(0);
+  cur_byte_.push_back(0);
+  match_length_.push_back(0);
+  lookup_.push_back(false);
+  limit_.push_back(limit);
+  delta_.push_back(delta);
+  divisor_.push_back(1.0 / (limit + delta));
+  requested_size_ += map_size;
+  for (int i = 0; i < 256; ++i) {
+    predictions_.push_back(0.5 + (i + 0.5) / 512);
+    counts_.push_back(0);
+  }
+  outputs_.resize(byte_contexts_.size(), 0.5);
+}
+
+void MatchBank::Allocate() {
+  // The shared table is the largest power of two within the sum of the
+  // requested sizes: unlike separate tables it has no per-model slack.
+  table_bits_ = 1;
+  while (2ULL << table_bits_ <= requested_size_) ++table_bits_;
+  table_.resize(1ULL << table_bits_, 0);
+  checksums_.resize(table_.size(), 0);
+}
+
+const std::valarray<float>& MatchBank::Predict() {
+  if (bit_pos_ == 128) {
+    for (unsigned int i = 0; i < outputs_.size(); ++i) {
+      if (lookup_[i]) {
+        if (checksums_[table_index_[i]] == checksum_[i]) {
+          cur_match_[i] = table_[table_index_[i]];
+        } else {
+          cur_match_[i] = (cur_match_[i] + 1) % history_.size();
+        }
+      }
+      cur_byte_[i] = history_[cur_match_[i]];
+    }
+  }
+  for (unsigned int i = 0; i < outputs_.size(); ++i) {
+    float p = predictions_[i * 256 + match_length_[i]];
+    if (cur_byte_[i] & bit_pos_) outputs_[i] = p;
+    else outputs_[i] = 1 - p;
+  }
+  return outputs_;
+}
+
+void MatchBank::Perceive(int bit) {
+  for (unsigned int i = 0; i < outputs_.size(); ++i) {
+    int match = 0;
+    if (bit == ((cur_byte_[i] & bit_pos_) != 0)) match = 1;
+
+    int& count = counts_[i * 256 + match_length_[i]];
+    float& p = predictions_[i * 256 + match_length_[i]];
+    float divisor = divisor_[i];
+    if (count < limit_[i]) {
+      ++count;
+      divisor = 1.0 / (count + delta_[i]);
+    }
+    p += (match - p) * divisor;
+
+    if (match) {
+      if (match_length_[i] < 255) ++match_length_[i];
+    } else {
+      match_length_[i] = 0;
+    }
+  }
+  bit_pos_ /= 2;
+
+  if (bit_context_ >= 128) {
+    unsigned int position = history_pos_ % history_.size();
+    for (unsigned int i = 0; i < outputs_.size(); ++i) {
+      table_[table_index_[i]] = position;
+      checksums_[table_index_[i]] = checksum_[i];
+    }
+    ++history_pos_;
+  }
+}
+
+void MatchBank::ByteUpdate() {
+  for (unsigned int i = 0; i < outputs_.size(); ++i) {
+    unsigned long long hash = (*byte_contexts_[i] + 1) * 0x9E3779B97F4A7C15ULL;
+    hash = (hash ^ (i + 1) * 0xC2B2AE3D27D4EB4FULL) * 0x9E3779B97F4A7C15ULL;
+    table_index_[i] = hash >> (64 - table_bits_);
+    checksum_[i] = hash;
+    lookup_[i] = match_length_[i] < 8;
+    if (lookup_[i]) {
+      __builtin_prefetch(&table_[table_index_[i]]);
+      __builtin_prefetch(&checksums_[table_index_[i]]);
+    } else {
+      ++cur_match_[i];
+      cur_match_[i] %= history_.size();
+      __builtin_prefetch(&history_[cur_match_[i]]);
+    }
+    unsigned long long match_context = match_length_[i] / 32;
+    *longest_match_ = std::max(*longest_match_, match_context);
+  }
+  bit_pos_ = 128;
+}
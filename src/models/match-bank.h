@@ -0,0 +1,49 @@
+#ifndef MATCH_BANK_H
+#define MATCH_BANK_H
+
+#include "model.h"
+
+#include <vector>
+
+// All match models: each remembers the history position that last followed
+// its byte context and predicts the bits of the byte found there, with a
+// confidence that depends on the current match length. The positions of all
+// models live in one hash table, tagged with a 16-bit checksum of the model
+// and context so that a collision is rejected instead of followed. Per-model data
+// is kept in parallel arrays and all models are updated in one loop. Outputs
+// are in the order of Add() calls.
+class MatchBank : public Model {
+ public:
+  MatchBank(const std::vector<unsigned char>& history,
+      const unsigned int& bit_context, unsigned long long* longest_match);
+  void Add(const unsigned long long& byte_context, int limit, float delta,
+      unsigned long long map_size);
+  // Sizes the shared table. Called once, after the last Add().
+  void Allocate();
+  const std::valarray<float>& Predict();
+  void Perceive(int bit);
+  void ByteUpdate();
+
+ private:
+  const std::vector<unsigned char>& history_;
+  const unsigned int& bit_context_;
+  unsigned long long* longest_match_;
+  unsigned long long history_pos_;
+  unsigned char bit_pos_;
+  std::vector<const unsigned long long*> byte_contexts_;
+  std::vector<unsigned long long> cur_match_, table_index_;
+  std::vector<unsigned short> checksum_;
+  std::vector<unsigned char> cur_byte_, match_length_, lookup_;
+  std::vector<int> limit_;
+  std::vector<float> delta_, divisor_;
+  // History positions, and in a parallel array the checksum of the context
+  // that stored each one.
+  std::vector<unsigned int> table_;
+  std::vector<unsigned short> checksums_;
+  unsigned long long requested_size_;
+  int table_bits_;
+  std::vector<float> predictions_;
+  std::vector<int> counts_;
+};
+
+#endif
@@ -3,6 +3,10 @@
 
 #include <valarray>
 
+// At a byte boundary ByteUpdate() is called on every model before any of them
+// predicts the next bit. ByteUpdate() should only compute the table slots for
+// the coming byte and prefetch them; the loads happen in Predict(), so that the
+// cache misses of all models overlap.
 class Model {
  public:
   Model() : outputs_(0.5, 1) {}
@@ -53,6 +53,7 @@ typedef unsigned char U8;
 typedef unsigned short U16;
 typedef unsigned int U32;
 typedef unsigned long long U64;
+typedef long long I64;
 
 #ifndef min
 inline int min(int a, int b) {return a<b?a:b;}
@@ -163,7 +164,7 @@ public:
   }
 } rnd;
 
-int pos;
+I64 pos;
 
 class Buf {
   Array<U8> b;
@@ -194,7 +195,7 @@ int y=0;
 int c0=1;
 U32 c4=0;
 int bpos=0;
-int blpos=0;
+I64 blpos=0;
 Buf buf;
 
 int dt[1024];  // i -> 16K/(i+3)
@@ -2760,7 +2761,7 @@ private:
   Cache<Sentence, 4> Sentences;
   Cache<Paragraph, 2> Paragraphs;
   Array<U32> WordPos;
-  U32 BytePos[256];
+  I64 BytePos[256];
   Word *cWord, *pWord; // current word, previous word
   Segment *cSegment; // current segment
   Sentence *cSentence; // current sentence
@@ -2828,7 +2829,7 @@ public:
     cSegment = &Segments(0);
     cSentence = &Sentences(0);
     cParagraph = &Paragraphs(0);
-    memset(&BytePos[0], 0, 256*sizeof(U32));
+    memset(&BytePos[0], 0, sizeof(BytePos));
   }
   ~TextModel() {
     for (int i=0; i<Language::Count-1; i++) {
@@ -3524,9 +3525,9 @@ void wordModel(Mixer& m) {
     static U32 text0=0,data0=0,type0=0;
     static U32 lastLetter=0, firstLetter=0, lastUpper=0, lastDigit=0, wordGap=0;
     static ContextMap cm(MEM()*16, 61);
-    static int nl1=-3, nl=-2;
+    static I64 nl1=-3, nl=-2;
     static U32 mask=0, mask2=0;
-    static Array<int> wpos(0x10000);
+    static Array<I64> wpos(0x10000);
     static int w=0;
     static Array<Word> StemWords(4);
     static Word *cWord=&StemWords[0], *pWord=&StemWords[3];
@@ -3848,12 +3849,13 @@ struct dBASE {
 };
 
 void recordModel(Mixer& m, Filetype filetype, ModelStats *Stats = nullptr) {
-  static int cpos1[256] , cpos2[256], cpos3[256], cpos4[256];
-  static int wpos1[0x10000];
+  static I64 cpos1[256] , cpos2[256], cpos3[256], cpos4[256];
+  static I64 wpos1[0x10000];
   static int rlen[3] = {2,3,4}; // run length and 2 candidates
   static int rcount[2] = {0,0}; // candidate counts
   static U8 padding = 0; // detected padding byte
-  static int prevTransition = 0, nTransition = 0; // position of the last padding transition
+  static I64 prevTransition = 0;
+  static int nTransition = 0; // position of the last padding transition
   static int col = 0, mxCtx = 0;
   static ContextMap cm(32768, 3), cn(32768/2, 3), co(32768*2, 3), cp(MEM(), 7);
   static StationaryMap Map0(10,8), Map1(10,8);
@@ -4031,8 +4033,8 @@ void recordModel(Mixer& m, Filetype filetype, ModelStats *Stats = nullptr) {
 }
 
 void recordModel1(Mixer& m) {
-  static int cpos1[256];
-  static int wpos1[0x10000];
+  static I64 cpos1[256];
+  static I64 wpos1[0x10000];
   static ContextMap cm(32768, 2), cn(32768/2, 4+1), co(32768*4, 4),cp(32768*2, 3), cq(32768*2, 3);
 
   if (!bpos) {
@@ -4167,7 +4169,7 @@ void sparseModel1(Mixer& m, int seenbefore, int howmany) {
 void distanceModel(Mixer& m) {
   static ContextMap cr(MEM(), 3);
   if( bpos == 0 ){
-    static int pos00=0,pos20=0,posnl=0;
+    static I64 pos00=0,pos20=0,posnl=0;
     int c=c4&0xff;
     if(c==0x00)pos00=pos;
     if(c==0x20)pos20=pos;
@@ -4307,7 +4309,8 @@ void im8bitModel(Mixer& m, int w, ModelStats *Stats = nullptr, int gray = 0) {
      {8,8}, {8,8}, {8,8}, {8,8}, {8,8}, {8,8}, {8,8}, {8,8}, {8,8}, {8,8}, {8,8}, {8,8}, {8,8}, {8,8}, {8,8}, {8,8}, {0,8}
   };
   static U8 WWW, WW, W, NWW, NW, N, NE, NEE, NNWW, NNW, NN, NNE, NNEE, NNN; //pixel neighborhood
-  static int ctx, lastPos=0, col=0, x=0;
+  static int ctx, col=0, x=0;
+  static I64 lastPos=0;
   static int columns[2] = {1,1}, column[2];
   // Select nearby pixels as context
   if (!bpos) {
@@ -4512,7 +4515,8 @@ void im24bitModel(Mixer& m, int w, ModelStats *Stats = nullptr, int alpha=0) {
   static U8 WWp1, Wp1, p1, NWp1, Np1, NEp1, NNp1;
   static U8 WWp2, Wp2, p2, NWp2, Np2, NEp2, NNp2;
   static int color = -1, stride = 3;
-  static int ctx[2], padding, lastPos, x = 0;
+  static int ctx[2], padding, x = 0;
+  static I64 lastPos;
   static int columns[2] = {1,1}, column[2];
 
   // Select nearby pixels as context
@@ -4819,7 +4823,8 @@ void im24bitModel(Mixer& m, int w, ModelStats *Stats = nullptr, int alpha=0) {
 }
 
 struct TGAImage{
-  U32 Header, IdLength, Bpp, ImgType, MapSize, Width, Height;
+  I64 Header;
+  U32 IdLength, Bpp, ImgType, MapSize, Width, Height;
 };
 struct BMPImage{
   U32 Header, Offset, Bpp, Size, Palette, HdrLess, Width, Height, BitMask;
@@ -4827,7 +4832,7 @@ struct BMPImage{
 
 int imgModel(Mixer& m, ModelStats *Stats = nullptr) {
   static int w=0, bpp=0;
-  static int eoi=0;
+  static I64 eoi=0;
   static BMPImage BMP;
   static TGAImage TGA;
   static int alpha=0, gray=0, pltorder=0;
@@ -4986,7 +4991,8 @@ inline int X2(int i) {
 void wavModel(Mixer& m, int info, ModelStats *Stats = nullptr) {
   static int pr[3][2], n[2], counter[2];
   static double F[49][49][2],L[49][49];
-  static int rpos=0, lastPos=0;
+  static int rpos=0;
+  static I64 lastPos=0;
   int j,k,l,i=0;
   long double sum;
   const double a=0.996,a2=1/a;
@@ -5132,15 +5138,17 @@ void wavModel(Mixer& m, int info, ModelStats *Stats = nullptr) {
 }
 
 struct WAVAudio{
-  U32 Header, Size, Channels, BitsPerSample, Chunk, Data;
+  I64 Header;
+  U32 Size, Channels, BitsPerSample, Chunk, Data;
 };
 
 int audioModel(Mixer& m, ModelStats *Stats = nullptr) {
-  static U32 eoi=0, length=0, info=0;
+  static I64 eoi=0;
+  static U32 length=0, info=0;
   static WAVAudio WAV;
 
   if (!bpos){
-    if (pos>=(int)(eoi+4) && !WAV.Header && m4(4)==0x52494646){
+    if (pos>=eoi+4 && !WAV.Header && m4(4)==0x52494646){
       WAV.Header = pos;
       WAV.Chunk = 0;
       length = 0;
@@ -5179,13 +5187,13 @@ int audioModel(Mixer& m, ModelStats *Stats = nullptr) {
     }
   }
 
-  if (pos>(int)eoi)
+  if (pos>eoi)
     return info=0;
 
   if (info)
     wavModel(m, info-1, Stats);
 
-  if (bpos==7 && (pos+1)==(int)eoi)
+  if (bpos==7 && (pos+1)==eoi)
     memset(&WAV, 0, sizeof(WAVAudio));
 
   return info;
@@ -5220,13 +5228,13 @@ public:
 struct HUF {U32 min, max; int val;};
 
 struct JPEGImage{
-  int offset, // offset of SOI marker
-  jpeg, // 1 if JPEG is header detected, 2 if image data
+  I64 offset; // offset of SOI marker
+  int jpeg, // 1 if JPEG is header detected, 2 if image data
   next_jpeg, // updated with jpeg on next byte boundary
-  app, // Bytes remaining to skip in this marker
-  sof, sos, data, // pointers to buf
-  htsize; // number of pointers in ht
-  int ht[8]; // pointers to Huffman table headers
+  app; // Bytes remaining to skip in this marker
+  I64 sof, sos, data; // pointers to buf
+  int htsize; // number of pointers in ht
+  I64 ht[8]; // pointers to Huffman table headers
   U8 qtab[256]; // table
   int qmap[10]; // block -> table number
 };
@@ -5239,7 +5247,7 @@ int jpegModel(Mixer& m) {
   const static int MaxEmbeddedLevel = 3;
   static JPEGImage images[MaxEmbeddedLevel];
   static int idx=-1;
-  static int lastPos=0;
+  static I64 lastPos=0;
 
   // Huffman decode state
   static U32 huffcode=0;  // Current Huffman code including extra bits
@@ -5288,7 +5296,8 @@ int jpegModel(Mixer& m) {
   static Array<int> lcp(7), zpos(64);
 
     //for parsing Quantization tables
-  static int dqt_state = -1, dqt_end = 0, qnum = 0;
+  static int dqt_state = -1, qnum = 0;
+  static I64 dqt_end = 0;
 
   const static U8 zzu[64]={  // zigzag coef -> u,v
     0,1,0,0,1,2,3,2,1,0,0,1,2,3,4,5,4,3,2,1,0,0,1,2,3,4,5,6,7,6,5,4,
@@ -5488,15 +5497,15 @@ int jpegModel(Mixer& m) {
     if (pos==images[idx].data && bpos==1) {
       int i;
       for (i=0; i<images[idx].htsize; ++i) {
-        int p=images[idx].ht[i]+4;  // pointer to current table after length field
-        int end=p+buf[p-2]*256+buf[p-1]-2;  // end of Huffman table
+        I64 p=images[idx].ht[i]+4;  // pointer to current table after length field
+        I64 end=p+buf[p-2]*256+buf[p-1]-2;  // end of Huffman table
         int count=0;  // sanity check
         while (p<end && end<pos && end<p+2100 && ++count<10) {
           int tc=buf[p]>>4, th=buf[p]&15;
           if (tc>=2 || th>=4) break;
           jassert(tc>=0 && tc<2 && th>=0 && th<4);
           HUF* h=&huf[tc*64+th*16]; // [tc][th][0];
-          int val=p+17;  // pointer to values
+          I64 val=p+17;  // pointer to values
           int hval=tc*1024+th*256;  // pointer to RS values in hbuf
           int j;
           for (j=0; j<256; ++j) // copy RS codes
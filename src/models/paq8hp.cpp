@@ -42,6 +42,7 @@ namespace {
 typedef unsigned char U8;
 typedef unsigned short U16;
 typedef unsigned int U32;
+typedef long long I64;
 
 #ifndef min
 inline int min(int a, int b) {return a<b?a:b;}
@@ -172,7 +173,7 @@ public:
   }
 } rnd;
 
-int pos;
+I64 pos;
 
 class Buf {
   Array<U8> b;
@@ -802,7 +803,7 @@ static U32 col, frstchar=0, spafdo=0, spaces=0, spacecount=0, words=0, wordcount
 void wordModel(Mixer& m) {
   static U32 word0=0, word1=0, word2=0, word3=0, word4=0;
   static ContextMap cm((unsigned int)MEM*16, 46);
-  static int nl1=-3, nl=-2;
+  static I64 nl1=-3, nl=-2;
   static U32 t1[256];
   static U16 t2[0x10000];
 
@@ -916,8 +917,8 @@ void wordModel(Mixer& m) {
 }
 
 void recordModel(Mixer& m) {
-  static int cpos1[256];
-  static int wpos1[0x10000];
+  static I64 cpos1[256];
+  static I64 wpos1[0x10000];
   static ContextMap cm(32768/4, 2), cn(32768/2, 5), co(32768, 4), cp(32768*2, 3), cq(32768*4, 3);
 
   if (!bpos) {
@@ -1,9 +1,7 @@
 #include "predictor.h"
-#include "models/direct.h"
-#include "models/direct-hash.h"
-#include "models/indirect.h"
-#include "models/byte-run.h"
-#include "models/match.h"
+#include "mixer/quantized-mixer.h"
+#include "mixer/lstm-byte-mixer.h"
+#include "mixer/gated-linear-byte-mixer.h"
 #include "models/ppmd.h"
 #include "models/bracket.h"
 #include "models/paq8.h"
@@ -21,18 +19,28 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-Predictor::Predictor(const std::vector<bool>& vocab) : manager_(),
-    sigmoid_(100001), vocab_(vocab) {
+Predictor::Predictor(const std::vector<bool>& vocab, unsigned char options,
+    unsigned int lstm_threads) :
+    manager_(),
+    direct_bank_(manager_.bit_context_),
+    indirect_bank_(manager_.bit_context_, manager_.shared_map_),
+    byte_run_bank_(manager_.bit_context_),
+    match_bank_(manager_.history_, manager_.bit_context_,
+    &(manager_.longest_match_)), vocab_(vocab), options_(options),
+    lstm_threads_(lstm_threads) {
   srand(0xDEADBEEF);
 
-  AddBracket();
+  // The auxiliary inputs are indexed by their position in the model outputs,
+  // so they have to be added before any model that lives in a bank.
   AddPAQ8HP();
   AddPAQ8();
+  AddBracket();
   AddPPMD();
   AddWord();
   AddDirect();
   AddMatch();
   AddDoubleIndirect();
+  match_bank_.Allocate();
   AddMixers();
 }
 
@@ -41,6 +49,10 @@ unsigned long long Predictor::GetNumModels() {
   for (unsigned int i = 0; i < models_.size(); ++i) {
     num += models_[i]->NumOutputs();
   }
+  num += direct_bank_.NumOutputs();
+  num += indirect_bank_.NumOutputs();
+  num += byte_run_bank_.NumOutputs();
+  num += match_bank_.NumOutputs();
   for (unsigned int i = 0; i < byte_models_.size(); ++i) {
     num += byte_models_[i]->NumOutputs();
   }
@@ -58,7 +70,17 @@ void Predictor::AddByteModel(ByteModel* model) {
   byte_models_.push_back(std::unique_ptr<ByteModel>(model));
 }
 
-void Predictor::AddMixer(int layer, Mixer* mixer) {
+void Predictor::AddMixer(int layer, const unsigned long long& context,
+    float learning_rate) {
+  const MixerInput& inputs = *layers_[layer];
+  Mixer* mixer;
+  if (inputs.IsQuantized()) {
+    mixer = new QuantizedMixer(inputs, context, learning_rate,
+        inputs.Inputs().size());
+  } else {
+    mixer = new Mixer(inputs.Inputs(), context, learning_rate,
+        inputs.Inputs().size());
+  }
   mixers_[layer].push_back(std::unique_ptr<Mixer>(mixer));
 }
 
@@ -85,12 +107,10 @@ void Predictor::AddPAQ8() {
 
 void Predictor::AddBracket() {
   AddModel(new Bracket(manager_.bit_context_, 200, 10, 100000, vocab_));
-  const Context& context = manager_.AddContext(std::unique_ptr<Context>(
-      new BracketContext(manager_.bit_context_, 256, 15)));
-  AddModel(new Direct(context.GetContext(), manager_.bit_context_, 30, 0,
-      context.Size()));
-  AddModel(new Indirect(manager_.nonstationary_, context.GetContext(),
-      manager_.bit_context_, 300, manager_.shared_map_));
+  const Context& context = manager_.AddContext(
+      BracketContext(manager_.bit_context_, 256, 15));
+  direct_bank_.Add(context.GetContext(), 30, 0, context.Size());
+  indirect_bank_.Add(manager_.nonstationary_, context.GetContext(), 300);
 }
 
 void Predictor::AddPPMD() {
@@ -105,26 +125,22 @@ void Predictor::AddWord() {
       {1, 2, 4}, {1, 2, 3, 4}, {2, 3, 4}, {2}, {1, 2, 3, 4, 5},
       {1, 2, 3, 4, 5, 6}};
   for (const auto& params : model_params) {
-    std::unique_ptr<Context> hash(new Sparse(manager_.words_, params));
-    const Context& context = manager_.AddContext(std::move(hash));
-    AddModel(new Indirect(manager_.nonstationary_, context.GetContext(),
-        manager_.bit_context_, delta, manager_.shared_map_));
+    const Context& context = manager_.AddContext(
+        Sparse(manager_.words_, params));
+    indirect_bank_.Add(manager_.nonstationary_, context.GetContext(),
+        delta);
   }
 
   std::vector<std::vector<unsigned int>> model_params2 = {{0}, {1}, {7},
       {1, 3}, {1, 2, 3}, {7, 2}};
   for (const auto& params : model_params2) {
-    std::unique_ptr<Context> hash(new Sparse(manager_.words_, params));
-    const Context& context = manager_.AddContext(std::move(hash));
-    AddModel(new Match(manager_.history_, context.GetContext(),
-        manager_.bit_context_, 200, 0.5, 10000000, &(manager_.longest_match_)));
-    AddModel(new ByteRun(context.GetContext(), manager_.bit_context_, 100,
-        10000000));
+    const Context& context = manager_.AddContext(
+        Sparse(manager_.words_, params));
+    match_bank_.Add(context.GetContext(), 200, 0.5, 10000000);
+    byte_run_bank_.Add(context.GetContext(), 100, 10000000);
     if (params[0] == 1 && params.size() == 1) {
-      AddModel(new Indirect(manager_.run_map_, context.GetContext(),
-          manager_.bit_context_, delta, manager_.shared_map_));
-      AddModel(new DirectHash(context.GetContext(), manager_.bit_context_, 30,
-          0, 500000));
+      indirect_bank_.Add(manager_.run_map_, context.GetContext(), delta);
+      direct_bank_.AddHashed(context.GetContext(), 30, 0, 500000);
     }
   }
 }
@@ -134,14 +150,12 @@ void Predictor::AddDirect() {
   int limit = 30;
   std::vector<std::vector<int>> model_params = {{0, 8}, {1, 8}, {2, 8}, {3, 8}};
   for (const auto& params : model_params) {
-    const Context& context = manager_.AddContext(std::unique_ptr<Context>(
-        new ContextHash(manager_.bit_context_,params[0], params[1])));
+    const Context& context = manager_.AddContext(
+        ContextHash(manager_.bit_context_,params[0], params[1]));
     if (params[0] < 3) {
-      AddModel(new Direct(context.GetContext(), manager_.bit_context_, limit,
-          delta, context.Size()));
+      direct_bank_.Add(context.GetContext(), limit, delta, context.Size());
     } else {
-      AddModel(new DirectHash(context.GetContext(), manager_.bit_context_,
-          limit, delta, 100000));
+      direct_bank_.AddHashed(context.GetContext(), limit, delta, 100000);
     }
   }
 }
@@ -154,11 +168,10 @@ void Predictor::AddMatch() {
       {11, 3}, {13, 2}, {15, 2}, {17, 2}, {20, 1}, {25, 1}};
 
   for (const auto& params : model_params) {
-    const Context& context = manager_.AddContext(std::unique_ptr<Context>(
-        new ContextHash(manager_.bit_context_,params[0], params[1])));
-    AddModel(new Match(manager_.history_, context.GetContext(),
-        manager_.bit_context_, limit, delta, std::min(max_size, context.Size()),
-        &(manager_.longest_match_)));
+    const Context& context = manager_.AddContext(
+        ContextHash(manager_.bit_context_,params[0], params[1]));
+    match_bank_.Add(context.GetContext(), limit, delta,
+        std::min(max_size, context.Size()));
   }
 }
 
@@ -168,11 +181,11 @@ void Predictor::AddDoubleIndirect() {
       {2, 8, 1, 8}, {1, 8, 2, 8}, {2, 8, 2, 8}, {1, 8, 3, 8}, {3, 8, 1, 8},
       {4, 6, 4, 8}, {5, 5, 5, 5}, {1, 8, 4, 8}, {1, 8, 5, 6}, {6, 4, 6, 4}};
   for (const auto& params : model_params) {
-    const Context& context = manager_.AddContext(std::unique_ptr<Context>(
-        new IndirectHash(manager_.bit_context_, params[0], params[1],
-        params[2], params[3])));
-    AddModel(new Indirect(manager_.nonstationary_, context.GetContext(),
-        manager_.bit_context_, delta, manager_.shared_map_));
+    const Context& context = manager_.AddContext(
+        IndirectHash(manager_.bit_context_, params[0], params[1],
+        params[2], params[3]));
+    indirect_bank_.Add(manager_.nonstationary_, context.GetContext(),
+        delta);
   }
 }
 
@@ -181,13 +194,22 @@ void Predictor::AddMixers() {
   for (unsigned int i = 0; i < vocab_.size(); ++i) {
     if (vocab_[i]) ++vocab_size;
   }
-  AddByteMixer(new ByteMixer(byte_models_.size(), 200, 2, 40, 0.03, 10,
-      manager_.bit_context_, vocab_, vocab_size));
+  bool deferred_training = options_ & kDeferredLstmTraining;
+  bool half_precision = options_ & kHalfPrecisionLstm;
+  if (options_ & kLinearByteMixer) {
+    AddByteMixer(new GatedLinearByteMixer(byte_models_.size(), 0.02,
+        manager_.bit_context_, vocab_, vocab_size));
+  } else {
+    AddByteMixer(new LstmByteMixer(byte_models_.size(), 200, 2, 40, 0.03, 10,
+        manager_.bit_context_, vocab_, vocab_size, lstm_threads_,
+        deferred_training, half_precision));
+  }
   AddAuxiliary();
 
+  bool quantized = options_ & kQuantizedMixer;
   for (int i = 0; i < 3; ++i) {
-    layers_.push_back(std::unique_ptr<MixerInput>(new MixerInput(sigmoid_,
-        1.0e-4)));
+    layers_.push_back(std::unique_ptr<MixerInput>(new MixerInput(1.0e-4,
+        quantized)));
     mixers_.push_back(std::vector<std::unique_ptr<Mixer>>());
   }
 
@@ -197,38 +219,31 @@ void Predictor::AddMixers() {
       {0, 8, 0.0005}, {1, 8, 0.005}, {1, 8, 0.0005}, {2, 4, 0.005},
       {3, 2, 0.002}};
   for (const auto& params : model_params) {
-    const Context& context = manager_.AddContext(std::unique_ptr<Context>(
-        new ContextHash(manager_.bit_context_, params[0], params[1])));
-    const BitContext& bit_context = manager_.AddBitContext(std::unique_ptr
-        <BitContext>(new BitContext(manager_.long_bit_context_,
-        context.GetContext(), context.Size())));
-    AddMixer(0, new Mixer(layers_[0]->Inputs(), bit_context.GetContext(),
-        params[2], input_size));
+    const Context& context = manager_.AddContext(
+        ContextHash(manager_.bit_context_, params[0], params[1]));
+    const BitContext& bit_context = manager_.AddBitContext(
+        BitContext(manager_.long_bit_context_,
+        context.GetContext(), context.Size()));
+    AddMixer(0, bit_context.GetContext(), params[2]);
   }
 
   model_params = {{0, 0.001}, {2, 0.002}, {3, 0.005}};
   for (const auto& params : model_params) {
-    AddMixer(0, new Mixer(layers_[0]->Inputs(),
-        manager_.recent_bytes_[params[0]], params[1], input_size));
-  }
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), manager_.zero_context_, 0.00005,
-      input_size));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), manager_.line_break_, 0.0007,
-      input_size));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), manager_.longest_match_, 0.0005,
-      input_size));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), manager_.auxiliary_context_,
-      0.0005, input_size));
+    AddMixer(0, manager_.recent_bytes_[params[0]], params[1]);
+  }
+  AddMixer(0, manager_.zero_context_, 0.00005);
+  AddMixer(0, manager_.line_break_, 0.0007);
+  AddMixer(0, manager_.longest_match_, 0.0005);
+  AddMixer(0, manager_.auxiliary_context_, 0.0005);
 
   std::vector<int> map(256, 0);
   for (int i = 0; i < 256; ++i) {
     map[i] = (i < 1) + (i < 32) + (i < 64) + (i < 128) + (i < 255) +
       (i < 142) + (i < 138) + (i < 140) + (i < 137) + (i < 97);
   }
-  const Context& interval1 = manager_.AddContext(std::unique_ptr<Context>(
-      new Interval(manager_.bit_context_, map, 8)));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), interval1.GetContext(), 0.001,
-      input_size));
+  const Context& interval1 = manager_.AddContext(
+      Interval(manager_.bit_context_, map, 8));
+  AddMixer(0, interval1.GetContext(), 0.001);
 
   for (int i = 0; i < 256; ++i) {
     map[i] = (i < 41) + (i < 92) + (i < 124) + (i < 58) +
@@ -236,45 +251,39 @@ void Predictor::AddMixers() {
         (i < 64) + (i < 4) + (i < 61) + (i < 97) +
         (i < 125) + (i < 45) + (i < 48);
   }
-  const Context& interval2 = manager_.AddContext(std::unique_ptr<Context>(
-      new Interval(manager_.bit_context_, map, 8)));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), interval2.GetContext(), 0.001,
-      input_size));
+  const Context& interval2 = manager_.AddContext(
+      Interval(manager_.bit_context_, map, 8));
+  AddMixer(0, interval2.GetContext(), 0.001);
 
   for (int i = 0; i < 256; ++i) map[i] = 0;
   for (int i = 'a'; i <= 'z'; ++i) map[i] = 1;
   for (int i = 'A'; i <= 'Z'; ++i) map[i] = 1;
   for (int i = '0'; i <= '9'; ++i) map[i] = 1;
   for (int i = 0x80; i < 256; ++i) map[i] = 1;
-  const Context& interval3 = manager_.AddContext(std::unique_ptr<Context>(
-      new Interval(manager_.bit_context_, map, 7)));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), interval3.GetContext(), 0.001,
-      input_size));
-  const BitContext& bit_context5 = manager_.AddBitContext(std::unique_ptr
-      <BitContext>(new BitContext(manager_.long_bit_context_,
-      interval3.GetContext(), interval3.Size())));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), bit_context5.GetContext(), 0.005,
-      input_size));
+  const Context& interval3 = manager_.AddContext(
+      Interval(manager_.bit_context_, map, 7));
+  AddMixer(0, interval3.GetContext(), 0.001);
+  const BitContext& bit_context5 = manager_.AddBitContext(
+      BitContext(manager_.long_bit_context_,
+      interval3.GetContext(), interval3.Size()));
+  AddMixer(0, bit_context5.GetContext(), 0.005);
 
   for (int i = 0; i < 256; ++i) map[i] = 0;
   for (int i = 0x30; i < 0x60; ++i) map[i] = 1;
   for (int i = 0x60; i < 0xD0; ++i) map[i] = 2;
   for (int i = 0xD0; i < 256; ++i) map[i] = 3;
-  const Context& interval4 = manager_.AddContext(std::unique_ptr<Context>(
-      new Interval(manager_.bit_context_, map, 10)));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), interval4.GetContext(), 0.001,
-      input_size));
-  const Context& interval5 = manager_.AddContext(std::unique_ptr<Context>(
-      new Interval(manager_.bit_context_, map, 15)));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), interval5.GetContext(), 0.001,
-      input_size));
-  const Context& interval8 = manager_.AddContext(std::unique_ptr<Context>(
-      new Interval(manager_.bit_context_, map, 7)));
-  const BitContext& bit_context4 = manager_.AddBitContext(std::unique_ptr
-      <BitContext>(new BitContext(manager_.long_bit_context_,
-      interval8.GetContext(), interval8.Size())));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), bit_context4.GetContext(), 0.005,
-      input_size));
+  const Context& interval4 = manager_.AddContext(
+      Interval(manager_.bit_context_, map, 10));
+  AddMixer(0, interval4.GetContext(), 0.001);
+  const Context& interval5 = manager_.AddContext(
+      Interval(manager_.bit_context_, map, 15));
+  AddMixer(0, interval5.GetContext(), 0.001);
+  const Context& interval8 = manager_.AddContext(
+      Interval(manager_.bit_context_, map, 7));
+  const BitContext& bit_context4 = manager_.AddBitContext(
+      BitContext(manager_.long_bit_context_,
+      interval8.GetContext(), interval8.Size()));
+  AddMixer(0, bit_context4.GetContext(), 0.005);
 
   for (int i = 0; i < 256; ++i) map[i] = 0;
   for (int i = 0x20; i <= 0x7E; ++i) map[i] = 1;
@@ -284,104 +293,82 @@ void Predictor::AddMixers() {
   for (int i = 0xD0; i <= 0xEF; ++i) map[i] = 5;
   for (int i = 0xF0; i <= 0xFF; ++i) map[i] = 6;
   map[' '] = 7;
-  const Context& interval6 = manager_.AddContext(std::unique_ptr<Context>(
-      new Interval(manager_.bit_context_, map, 9)));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), interval6.GetContext(), 0.001,
-      input_size));
-  const Context& interval7 = manager_.AddContext(std::unique_ptr<Context>(
-      new IntervalHash(manager_.bit_context_, map, 8, 7, 2)));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), interval7.GetContext(), 0.001,
-      input_size));
-  const Context& interval9 = manager_.AddContext(std::unique_ptr<Context>(
-      new Interval(manager_.bit_context_, map, 7)));
-  const BitContext& bit_context6 = manager_.AddBitContext(std::unique_ptr
-      <BitContext>(new BitContext(manager_.long_bit_context_,
-      interval9.GetContext(), interval9.Size())));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), bit_context6.GetContext(), 0.005,
-      input_size));
-
-  const BitContext& bit_context1 = manager_.AddBitContext(std::unique_ptr
-      <BitContext>(new BitContext(manager_.long_bit_context_,
-      manager_.recent_bytes_[1], 256)));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), bit_context1.GetContext(), 0.005,
-      input_size));
-
-  const Context& combined1 = manager_.AddContext(std::unique_ptr
-      <Context>(new CombinedContext(manager_.recent_bytes_[1],
-      manager_.recent_bytes_[0], 256, 256)));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), combined1.GetContext(), 0.005,
-      input_size));
-
-  const Context& combined2 = manager_.AddContext(std::unique_ptr
-      <Context>(new CombinedContext(manager_.recent_bytes_[2],
-      manager_.recent_bytes_[1], 256, 256)));
-  AddMixer(0, new Mixer(layers_[0]->Inputs(), combined2.GetContext(), 0.003,
-      input_size));
+  const Context& interval6 = manager_.AddContext(
+      Interval(manager_.bit_context_, map, 9));
+  AddMixer(0, interval6.GetContext(), 0.001);
+  const Context& interval7 = manager_.AddContext(
+      IntervalHash(manager_.bit_context_, map, 8, 7, 2));
+  AddMixer(0, interval7.GetContext(), 0.001);
+  const Context& interval9 = manager_.AddContext(
+      Interval(manager_.bit_context_, map, 7));
+  const BitContext& bit_context6 = manager_.AddBitContext(
+      BitContext(manager_.long_bit_context_,
+      interval9.GetContext(), interval9.Size()));
+  AddMixer(0, bit_context6.GetContext(), 0.005);
+
+  const BitContext& bit_context1 = manager_.AddBitContext(
+      BitContext(manager_.long_bit_context_,
+      manager_.recent_bytes_[1], 256));
+  AddMixer(0, bit_context1.GetContext(), 0.005);
+
+  const Context& combined1 = manager_.AddContext(
+      CombinedContext(manager_.recent_bytes_[1], manager_.recent_bytes_[0],
+      256, 256));
+  AddMixer(0, combined1.GetContext(), 0.005);
+
+  const Context& combined2 = manager_.AddContext(
+      CombinedContext(manager_.recent_bytes_[2], manager_.recent_bytes_[1],
+      256, 256));
+  AddMixer(0, combined2.GetContext(), 0.003);
 
   input_size = mixers_[0].size() + auxiliary_.size();
   layers_[1]->SetNumModels(input_size);
 
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), manager_.zero_context_, 0.005,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), manager_.zero_context_, 0.0005,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), manager_.long_bit_context_, 0.005,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), manager_.long_bit_context_,
-      0.0005, input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), manager_.long_bit_context_,
-      0.00001, input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), manager_.recent_bytes_[0], 0.005,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), manager_.recent_bytes_[1], 0.005,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), manager_.recent_bytes_[2], 0.005,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), manager_.longest_match_, 0.0005,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), interval1.GetContext(), 0.001,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), interval2.GetContext(), 0.001,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), interval3.GetContext(), 0.001,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), interval4.GetContext(), 0.001,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), interval5.GetContext(), 0.001,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), interval6.GetContext(), 0.001,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), interval7.GetContext(), 0.001,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), bit_context4.GetContext(), 0.001,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), bit_context5.GetContext(), 0.001,
-      input_size));
-  AddMixer(1, new Mixer(layers_[1]->Inputs(), bit_context6.GetContext(), 0.001,
-      input_size));
+  AddMixer(1, manager_.zero_context_, 0.005);
+  AddMixer(1, manager_.zero_context_, 0.0005);
+  AddMixer(1, manager_.long_bit_context_, 0.005);
+  AddMixer(1, manager_.long_bit_context_, 0.0005);
+  AddMixer(1, manager_.long_bit_context_, 0.00001);
+  AddMixer(1, manager_.recent_bytes_[0], 0.005);
+  AddMixer(1, manager_.recent_bytes_[1], 0.005);
+  AddMixer(1, manager_.recent_bytes_[2], 0.005);
+  AddMixer(1, manager_.longest_match_, 0.0005);
+  AddMixer(1, interval1.GetContext(), 0.001);
+  AddMixer(1, interval2.GetContext(), 0.001);
+  AddMixer(1, interval3.GetContext(), 0.001);
+  AddMixer(1, interval4.GetContext(), 0.001);
+  AddMixer(1, interval5.GetContext(), 0.001);
+  AddMixer(1, interval6.GetContext(), 0.001);
+  AddMixer(1, interval7.GetContext(), 0.001);
+  AddMixer(1, bit_context4.GetContext(), 0.001);
+  AddMixer(1, bit_context5.GetContext(), 0.001);
+  AddMixer(1, bit_context6.GetContext(), 0.001);
 
   input_size = mixers_[0].size() + mixers_[1].size() + auxiliary_.size();
   layers_[2]->SetNumModels(input_size);
-  AddMixer(2, new Mixer(layers_[2]->Inputs(), manager_.zero_context_, 0.0003,
-      input_size));
+  AddMixer(2, manager_.zero_context_, 0.0003);
 }
 
 float Predictor::Predict() {
   unsigned int input_index = 0;
   for (unsigned int i = 0; i < models_.size(); ++i) {
     const std::valarray<float>& outputs = models_[i]->Predict();
-    for (unsigned int j = 0; j < outputs.size(); ++j) {
-      layers_[0]->SetInput(input_index, outputs[j]);
-      ++input_index;
-    }
+    layers_[0]->SetInputs(input_index, outputs);
+    input_index += outputs.size();
   }
+  layers_[0]->SetInputs(input_index, direct_bank_.Predict());
+  input_index += direct_bank_.NumOutputs();
+  layers_[0]->SetInputs(input_index, indirect_bank_.Predict());
+  input_index += indirect_bank_.NumOutputs();
+  layers_[0]->SetInputs(input_index, byte_run_bank_.Predict());
+  input_index += byte_run_bank_.NumOutputs();
+  layers_[0]->SetInputs(input_index, match_bank_.Predict());
+  input_index += match_bank_.NumOutputs();
 
   for (unsigned int i = 0; i < byte_models_.size(); ++i) {
     const std::valarray<float>& outputs = byte_models_[i]->Predict();
-    for (unsigned int j = 0; j < outputs.size(); ++j) {
-      layers_[0]->SetInput(input_index, outputs[j]);
-      ++input_index;
-    }
+    layers_[0]->SetInputs(input_index, outputs);
+    input_index += outputs.size();
   }
   float byte_mixer_override = -1;
   for (unsigned int i = 0; i < byte_mixers_.size(); ++i) {
@@ -426,6 +413,7 @@ void Predictor::Perceive(int bit) {
   for (const auto& model : models_) {
     model->Perceive(bit);
   }
+  PerceiveBanks(bit);
   for (const auto& model : byte_models_) {
     model->Perceive(bit);
   }
@@ -447,15 +435,13 @@ void Predictor::Perceive(int bit) {
     for (const auto& model : models_) {
       model->ByteUpdate();
     }
+    ByteUpdateBanks();
     for (const auto& model : byte_models_) {
       model->ByteUpdate();
     }
-    for (unsigned int i = 0; i < byte_models_.size(); ++i) {
-      const std::valarray<float>& p = byte_models_[i]->BytePredict();
+    for (const auto& model : byte_models_) {
       for (const auto& byte_mixer : byte_mixers_) {
-        for (unsigned int j = 0; j < 256; ++j) {
-          byte_mixer->SetInput(j, p[j]);
-        }
+        byte_mixer->SetInputs(model.get());
       }
     }
     for (const auto& byte_mixer : byte_mixers_) {
@@ -469,9 +455,14 @@ void Predictor::Pretrain(int bit) {
   for (const auto& model : models_) {
     model->Predict();
   }
+  direct_bank_.Predict();
+  indirect_bank_.Predict();
+  byte_run_bank_.Predict();
+  match_bank_.Predict();
   for (const auto& model : models_) {
     model->Perceive(bit);
   }
+  PerceiveBanks(bit);
   bool byte_update = false;
   if (manager_.bit_context_ >= 128) byte_update = true;
   manager_.UpdateContexts(bit);
@@ -479,6 +470,21 @@ void Predictor::Pretrain(int bit) {
     for (const auto& model : models_) {
       model->ByteUpdate();
     }
+    ByteUpdateBanks();
     manager_.bit_context_ = 1;
   }
 }
+
+void Predictor::PerceiveBanks(int bit) {
+  direct_bank_.Perceive(bit);
+  indirect_bank_.Perceive(bit);
+  byte_run_bank_.Perceive(bit);
+  match_bank_.Perceive(bit);
+}
+
+void Predictor::ByteUpdateBanks() {
+  direct_bank_.ByteUpdate();
+  indirect_bank_.ByteUpdate();
+  byte_run_bank_.ByteUpdate();
+  match_bank_.ByteUpdate();
+}
@@ -8,6 +8,10 @@
 #include "mixer/sse.h"
 #include "models/model.h"
 #include "models/byte-model.h"
+#include "models/direct-bank.h"
+#include "models/indirect-bank.h"
+#include "models/byte-run-bank.h"
+#include "models/match-bank.h"
 #include "context-manager.h"
 
 #include <vector>
@@ -16,7 +20,22 @@
 
 class Predictor {
  public:
-  Predictor(const std::vector<bool>& vocab);
+  // Flags stored in the archive header.
+  enum Option {
+    // Each LSTM horizon is trained in the background while the next one is
+    // coded, and its weight updates take effect one horizon late.
+    kDeferredLstmTraining = 1,
+    // The LSTM forward pass reads bfloat16 copies of the gate weights.
+    kHalfPrecisionLstm = 2,
+    // GatedLinearByteMixer replaces the LSTM byte mixer.
+    kLinearByteMixer = 4,
+    // The mixer layers use QuantizedMixer (int16 weights) instead of Mixer.
+    kQuantizedMixer = 8,
+  };
+  // lstm_threads is the number of threads used to train the LSTM. It is not
+  // stored in the archive: the output does not depend on it.
+  Predictor(const std::vector<bool>& vocab, unsigned char options,
+      unsigned int lstm_threads);
   float Predict();
   void Perceive(int bit);
   void Pretrain(int bit);
@@ -25,7 +44,8 @@ class Predictor {
   unsigned long long GetNumModels();
   void AddModel(Model* model);
   void AddByteModel(ByteModel* model);
-  void AddMixer(int layer, Mixer* mixer);
+  void AddMixer(int layer, const unsigned long long& context,
+      float learning_rate);
   void AddByteMixer(ByteMixer* byte_mixer);
   void AddAuxiliary();
   void AddPAQ8();
@@ -37,17 +57,26 @@ class Predictor {
   void AddMatch();
   void AddDoubleIndirect();
   void AddMixers();
+  void PerceiveBanks(int bit);
+  void ByteUpdateBanks();
 
+  ContextManager manager_;
   std::vector<std::unique_ptr<Model>> models_;
+  // The simple models are grouped by type and called without virtual
+  // dispatch. Their outputs follow those of models_.
+  DirectBank direct_bank_;
+  IndirectBank indirect_bank_;
+  ByteRunBank byte_run_bank_;
+  MatchBank match_bank_;
   std::vector<std::unique_ptr<ByteModel>> byte_models_;
   SSE sse_;
   std::vector<std::unique_ptr<MixerInput>> layers_;
   std::vector<std::vector<std::unique_ptr<Mixer>>> mixers_;
   std::vector<unsigned int> auxiliary_;
-  ContextManager manager_;
-  Sigmoid sigmoid_;
   std::vector<std::unique_ptr<ByteMixer>> byte_mixers_;
   std::vector<bool> vocab_;
+  unsigned char options_;
+  unsigned int lstm_threads_;
 };
 
 #endif
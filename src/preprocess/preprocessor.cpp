@@ -1,5 +1,6 @@
 // This preprocessor is adapted from paq8l, paq8hp12any and paq8px.
 
+#include <algorithm>
 #include <vector>
 #include <cstdlib>
 #include <string.h>
@@ -28,16 +29,18 @@ bool IsAscii(int byte) {
 +    (((x) & 0x0000ff00) <<  8) | \
 +    (((x) & 0x000000ff) << 24))
 
-#define IMG_DET_NOHDR(type,start_pos,width,height) return detd=(width)*(height),info=(width),fseek(in, start+(start_pos), SEEK_SET),(type)
+#define IMG_DET_NOHDR(type,start_pos,width,height) return detd=(width)*(height),info=(width),Seek(in, start+(start_pos), SEEK_SET),(type)
 
-#define IMG_DET(type,start_pos,header_len,width,height) return dett=(type),deth=(header_len),detd=(width)*(height),info=(width),fseek(in, start+(start_pos), SEEK_SET),HDR
+#define IMG_DET(type,start_pos,header_len,width,height) return dett=(type),deth=(header_len),detd=(width)*(height),info=(width),Seek(in, start+(start_pos), SEEK_SET),HDR
 
 int info;
 
 void Pretrain(Predictor* p, FILE* dictionary) {
-  fseek(dictionary, 0L, SEEK_END);
-  unsigned int len = ftell(dictionary);
-  fseek(dictionary, 0L, SEEK_SET);
+  // The runner rejects dictionaries longer than kMaxSegmentLength, so the
+  // length fits the 32-bit segment header.
+  Seek(dictionary, 0, SEEK_END);
+  unsigned int len = static_cast<unsigned int>(Tell(dictionary));
+  Seek(dictionary, 0, SEEK_SET);
 
   std::vector<unsigned char> header;
   header.push_back(DEFAULT);
@@ -71,7 +74,7 @@ void Pretrain(Predictor* p, FILE* dictionary) {
 
 Filetype detect(FILE* in, int n, Filetype type) {
   U32 buf2=0, buf1=0, buf0=0;
-  long start=ftell(in);
+  long long start=Tell(in);
 
   // For EXE detection
   std::vector<int> abspos(256, 0),
@@ -93,8 +96,8 @@ Filetype detect(FILE* in, int n, Filetype type) {
   int imgbpp=0,bmpx=0,bmpy=0,bmpof=0;
   static int deth=0,detd=0;  // detected header/data size in bytes
   static Filetype dett;  // detected block type
-  if (deth) return fseek(in, start+deth, SEEK_SET),deth=0,dett;
-  else if (detd) return fseek(in, start+detd, SEEK_SET),detd=0,DEFAULT;
+  if (deth) return Seek(in, start+deth, SEEK_SET),deth=0,dett;
+  else if (detd) return Seek(in, start+detd, SEEK_SET),detd=0,DEFAULT;
   // For TGA detection
   uint64_t tga=0;
   int tgaid=0, tgaw=0, tgah=0;
@@ -117,7 +120,7 @@ Filetype detect(FILE* in, int n, Filetype type) {
       if (app<i && (buf1&0xff)==0xff && (buf0&0xfe0000ff)==0xc0000008) sof=i;
       if (sof && sof>soi && i-sof<0x1000 && (buf0&0xffff)==0xffda) {
         sos=i;
-        if (type!=JPEG) return fseek(in, start+soi-3, SEEK_SET), JPEG;
+        if (type!=JPEG) return Seek(in, start+soi-3, SEEK_SET), JPEG;
       }
       if (i-soi>0x40000 && !sos) soi=0;
     }
@@ -136,12 +139,12 @@ Filetype detect(FILE* in, int n, Filetype type) {
       }
       else e8e9count=0;
       if (type!=EXE && e8e9count>=4 && e8e9pos>5)
-        return fseek(in, start+e8e9pos-5, SEEK_SET), EXE;
+        return Seek(in, start+e8e9pos-5, SEEK_SET), EXE;
       abspos[a]=i;
       relpos[r]=i;
     }
     if (type==EXE && i-e8e9last>0x4000)
-      return fseek(in, start+e8e9last, SEEK_SET), DEFAULT;
+      return Seek(in, start+e8e9last, SEEK_SET), DEFAULT;
 
     // Detect TEXT
     if (type == DEFAULT) {
@@ -157,7 +160,7 @@ Filetype detect(FILE* in, int n, Filetype type) {
           if (space_count < 5) {
             ascii_start = -1;
           } else {
-            return fseek(in, start + ascii_start, SEEK_SET), TEXT;
+            return Seek(in, start + ascii_start, SEEK_SET), TEXT;
           }
         }
       } else {
@@ -170,7 +173,7 @@ Filetype detect(FILE* in, int n, Filetype type) {
       } else {
         ascii_run += 3;
         if (ascii_run > 300) {
-          return fseek(in, ftell(in) - 100, SEEK_SET), DEFAULT;
+          return Seek(in, Tell(in) - 100, SEEK_SET), DEFAULT;
         }
       }
     }
@@ -250,8 +253,8 @@ Filetype detect(FILE* in, int n, Filetype type) {
     
     // Detect .tiff image
     if (buf1==0x49492a00 && n>i+(int)bswap(buf0)) {
-      long savedpos=ftell(in);
-      fseek(in, start+i+bswap(buf0)-7, SEEK_SET);
+      long long savedpos=Tell(in);
+      Seek(in, start+i+bswap(buf0)-7, SEEK_SET);
 
       // read directory
       int dirsize=getc(in);
@@ -276,7 +279,7 @@ Filetype detect(FILE* in, int n, Filetype type) {
       }
       if (tifx && tify && tifzb && (tifz==1 || tifz==3) && (tifc==1) && (tifofs && tifofs+i<n)) {
         if (!tifofval) {
-          fseek(in, start+i+tifofs-7, SEEK_SET);
+          Seek(in, start+i+tifofs-7, SEEK_SET);
           for (int j=0; j<4; j++) b[j]=getc(in);
           tifofs=b[0]+(b[1]<<8)+(b[2]<<16)+(b[3]<<24);
         }
@@ -286,7 +289,7 @@ Filetype detect(FILE* in, int n, Filetype type) {
           else if (tifz==3 && tifzb==8) IMG_DET_NOHDR(IMAGE24, (i-7)+tifofs, tifx*3, tify);
         }
       }
-      fseek(in, savedpos, SEEK_SET);
+      Seek(in, savedpos, SEEK_SET);
     }
   }
   return type;
@@ -375,7 +378,9 @@ int decode_bmp(FILE *in, int &reset) {
   return -1;
 }
 
-void encode_exe(FILE* in, FILE* out, int len, int begin) {
+// Only the low 32 bits of the segment offset are stored; decode_exe undoes
+// the transform with the same value.
+void encode_exe(FILE* in, FILE* out, int len, unsigned int begin) {
   const int BLOCK=0x10000;
   std::vector<U8> blk(BLOCK);
   fprintf(out, "%c%c%c%c", len>>24, len>>16, len>>8, len);
@@ -405,7 +410,7 @@ int decode_exe(FILE* in) {
   const int BLOCK=0x10000;
   static int offset=0, q=0;
   static int size=0;
-  static int begin=0;
+  static unsigned int begin=0;
   static U8 c[6];
 
   while (offset==size && q==0) {
@@ -460,7 +465,7 @@ void encode_text(FILE* in, FILE* out, int len, string temp_path,
   wrt.defaultSettings(0, NULL);
   wrt.WRT_start_encoding(temp_input, temp_output, len, false, dictionary);
 
-  int size = ftell(temp_output);
+  int size = Tell(temp_output);
   if (size > len - 50) {
     for (int i = 0; i < 4; ++i) {
       putc(0, out);
@@ -523,44 +528,46 @@ int decode_text(FILE* in, FILE* dictionary) {
   return wrt_decoder->WRT_decode_char(wrt_temp, NULL, 0, dictionary);
 }
 
-void Encode(FILE* in, FILE* out, int n, string temp_path, FILE* dictionary) {
+void Encode(FILE* in, FILE* out, unsigned long long n, string temp_path,
+    FILE* dictionary) {
   Filetype type=DEFAULT;
-  long begin=ftell(in);
+  long long begin=Tell(in);
 
-  long start = begin;
-  int remainder = n;
-  int text_bytes = 0;
+  long long start = begin;
+  unsigned long long remainder = n;
+  unsigned long long text_bytes = 0;
   while (remainder > 0) {
-    Filetype nextType=detect(in, remainder, type);
-    long end=ftell(in);
+    Filetype nextType=detect(in, std::min(remainder, kMaxSegmentLength), type);
+    long long end=Tell(in);
     int len=int(end-begin);
     if (type == TEXT) text_bytes += len;
     remainder-=len;
     type=nextType;
     begin=end;
   }
-  fseek(in, start, SEEK_SET);
+  Seek(in, start, SEEK_SET);
   type = DEFAULT;
   begin = start;
 
   double text_fraction = text_bytes;
   text_fraction /= n;
-  if (text_fraction > 0.95) {
-    fprintf(out, "%c%c%c%c%c", TEXT, n>>24, n>>16, n>>8, n);
+  if (text_fraction > 0.95 && n <= kMaxSegmentLength) {
+    fprintf(out, "%c%c%c%c%c", TEXT, int(n>>24), int(n>>16), int(n>>8),
+        int(n));
     encode_text(in, out, n, temp_path, dictionary);
     return;
   }
 
   while (n>0) {
-    Filetype nextType=detect(in, n, type);
-    long end=ftell(in);
-    fseek(in, begin, SEEK_SET);
+    Filetype nextType=detect(in, std::min(n, kMaxSegmentLength), type);
+    long long end=Tell(in);
+    Seek(in, begin, SEEK_SET);
     int len=int(end-begin);
     if (len>0) {
       fprintf(out, "%c%c%c%c%c", type, len>>24, len>>16, len>>8, len);
       switch(type) {
         case IMAGE24: encode_bmp(in, out, len, info); break;
-        case EXE:     encode_exe(in, out, len, begin); break;
+        case EXE:     encode_exe(in, out, len, (unsigned int)begin); break;
         case TEXT:    encode_text(in, out, len, temp_path, dictionary); break;
         default: {
           if (HasInfo(type))
@@ -575,9 +582,13 @@ void Encode(FILE* in, FILE* out, int n, string temp_path, FILE* dictionary) {
   }
 }
 
-void NoPreprocess(FILE* in, FILE* out, int n) {
-  fprintf(out, "%c%c%c%c%c", DEFAULT, n>>24, n>>16, n>>8, n);
-  encode_default(in, out, n);
+void NoPreprocess(FILE* in, FILE* out, unsigned long long n) {
+  do {
+    int len = int(std::min(n, kMaxSegmentLength));
+    fprintf(out, "%c%c%c%c%c", DEFAULT, len>>24, len>>16, len>>8, len);
+    encode_default(in, out, len);
+    n -= len;
+  } while (n > 0);
 }
 
 int decode2(FILE* in, string temp_path, FILE* dictionary) {
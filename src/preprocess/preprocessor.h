@@ -14,10 +14,31 @@ typedef enum {DEFAULT, HDR, JPEG, EXE, TEXT, IMAGE1, IMAGE4, IMAGE8, IMAGE8GRAY,
 inline bool HasInfo(Filetype ft) { return ft==TEXT || ft==IMAGE1 || ft==IMAGE4
     || ft==IMAGE8 || ft==IMAGE8GRAY || ft==IMAGE24 || ft==IMAGE32; }
 
-void Encode(FILE* in, FILE* out, int n, std::string temp_path,
+// Segments are framed with 32-bit lengths, so longer inputs are split into
+// several segments of at most kMaxSegmentLength bytes.
+const unsigned long long kMaxSegmentLength = 0x7FFFFFFF;
+
+// ftell/fseek take a long, which is only 32 bits on Windows.
+inline long long Tell(FILE* f) {
+#ifdef _WIN32
+  return _ftelli64(f);
+#else
+  return ftello(f);
+#endif
+}
+
+inline int Seek(FILE* f, long long offset, int origin) {
+#ifdef _WIN32
+  return _fseeki64(f, offset, origin);
+#else
+  return fseeko(f, offset, origin);
+#endif
+}
+
+void Encode(FILE* in, FILE* out, unsigned long long n, std::string temp_path,
     FILE* dictionary);
 
-void NoPreprocess(FILE* in, FILE* out, int n);
+void NoPreprocess(FILE* in, FILE* out, unsigned long long n);
 
 void Pretrain(Predictor* p, FILE* dictionary);
 
@@ -22,15 +22,24 @@ int Help() {
   printf("Without preprocessing:\n");
   printf("    compress:   cmix -c [input] [output]\n");
   printf("    decompress: cmix -d [input] [output]\n");
+  printf("Compression flags, appended to -c (e.g. -cah):\n");
+  printf("    a: train the LSTM in the background\n");
+  printf("    h: store the LSTM weights read when predicting in bfloat16\n");
+  printf("    g: mix the byte models with a gated linear mixer instead of the\n"
+      "       LSTM (much faster, larger output)\n");
+  printf("    q: use int16 weights in the mixer layers\n");
+  printf("A digit appended to -c or -d (e.g. -ca4, -d4) sets the number of\n"
+      "threads used to train the LSTM. It does not change the output.\n");
   return -1;
 }
 
 void WriteHeader(unsigned long long length, const std::vector<bool>& vocab,
-    std::ofstream* os) {
+    unsigned char options, std::ofstream* os) {
   for (int i = 4; i >= 0; --i) {
     char c = length >> (8*i);
     os->put(c);
   }
+  os->put(options);
   if (length < kMinVocabFileSize) return;
   for (int i = 0; i < 32; ++i) {
     unsigned char c = 0;
@@ -48,13 +57,14 @@ void WriteStorageHeader(FILE* out) {
 }
 
 void ReadHeader(std::ifstream* is, unsigned long long* length,
-    std::vector<bool>* vocab) {
+    std::vector<bool>* vocab, unsigned char* options) {
   *length = 0;
   for (int i = 0; i < 5; ++i) {
     *length <<= 8;
     *length += (unsigned char)(is->get());
   }
   if (*length == 0) return;
+  *options = is->get();
   if (*length < kMinVocabFileSize) {
     std::fill(vocab->begin(), vocab->end(), true);
     return;
@@ -119,19 +129,20 @@ bool Store(const std::string& input_path, const std::string& temp_path,
   if (!data_in) return false;
   FILE* data_out = fopen(output_path.c_str(), "wb");
   if (!data_out) return false;
-  fseek(data_in, 0L, SEEK_END);
-  *input_bytes = ftell(data_in);
-  fseek(data_in, 0L, SEEK_SET);
+  preprocessor::Seek(data_in, 0, SEEK_END);
+  *input_bytes = preprocessor::Tell(data_in);
+  preprocessor::Seek(data_in, 0, SEEK_SET);
   WriteStorageHeader(data_out);
   preprocessor::Encode(data_in, data_out, *input_bytes, temp_path, dictionary);
-  fseek(data_out, 0L, SEEK_END);
-  *output_bytes = ftell(data_out);
+  preprocessor::Seek(data_out, 0, SEEK_END);
+  *output_bytes = preprocessor::Tell(data_out);
   fclose(data_in);
   fclose(data_out);
   return true;
 }
 
-bool RunCompression(bool enable_preprocess, const std::string& input_path,
+bool RunCompression(bool enable_preprocess, unsigned char options,
+    unsigned int threads, const std::string& input_path,
     const std::string& temp_path, const std::string& output_path,
     FILE* dictionary, unsigned long long* input_bytes,
     unsigned long long* output_bytes) {
@@ -140,9 +151,9 @@ bool RunCompression(bool enable_preprocess, const std::string& input_path,
   FILE* temp_out = fopen(temp_path.c_str(), "wb");
   if (!temp_out) return false;
 
-  fseek(data_in, 0L, SEEK_END);
-  *input_bytes = ftell(data_in);
-  fseek(data_in, 0L, SEEK_SET);
+  preprocessor::Seek(data_in, 0, SEEK_END);
+  *input_bytes = preprocessor::Tell(data_in);
+  preprocessor::Seek(data_in, 0, SEEK_SET);
 
   if (enable_preprocess) {
     preprocessor::Encode(data_in, temp_out, *input_bytes, temp_path,
@@ -171,8 +182,8 @@ bool RunCompression(bool enable_preprocess, const std::string& input_path,
     temp_in.seekg(0, std::ios::beg);
   }
 
-  WriteHeader(temp_bytes, vocab, &data_out);
-  Predictor p(vocab);
+  WriteHeader(temp_bytes, vocab, options, &data_out);
+  Predictor p(vocab, options, threads);
   if (enable_preprocess) preprocessor::Pretrain(&p, dictionary);
   Compress(temp_bytes, &temp_in, &data_out, output_bytes, &p);
   temp_in.close();
@@ -181,10 +192,10 @@ bool RunCompression(bool enable_preprocess, const std::string& input_path,
   return true;
 }
 
-bool RunDecompression(bool enable_preprocess, const std::string& input_path,
-    const std::string& temp_path, const std::string& output_path,
-    FILE* dictionary, unsigned long long* input_bytes,
-    unsigned long long* output_bytes) {
+bool RunDecompression(bool enable_preprocess, unsigned int threads,
+    const std::string& input_path, const std::string& temp_path,
+    const std::string& output_path, FILE* dictionary,
+    unsigned long long* input_bytes, unsigned long long* output_bytes) {
   std::ifstream data_in(input_path, std::ios::in | std::ios::binary);
   if (!data_in.is_open()) return false;
 
@@ -192,7 +203,8 @@ bool RunDecompression(bool enable_preprocess, const std::string& input_path,
   *input_bytes = data_in.tellg();
   data_in.seekg(0, std::ios::beg);
   std::vector<bool> vocab(256, false);
-  ReadHeader(&data_in, output_bytes, &vocab);
+  unsigned char options = 0;
+  ReadHeader(&data_in, output_bytes, &vocab, &options);
 
   if (*output_bytes == 0) {  // undo store
     if (!enable_preprocess) return false;
@@ -201,15 +213,15 @@ bool RunDecompression(bool enable_preprocess, const std::string& input_path,
     if (!in) return false;
     FILE* data_out = fopen(output_path.c_str(), "wb");
     if (!data_out) return false;
-    fseek(in, 5L, SEEK_SET);
+    preprocessor::Seek(in, 5, SEEK_SET);
     preprocessor::Decode(in, data_out, temp_path, dictionary);
-    fseek(data_out, 0L, SEEK_END);
-    *output_bytes = ftell(data_out);
+    preprocessor::Seek(data_out, 0, SEEK_END);
+    *output_bytes = preprocessor::Tell(data_out);
     fclose(in);
     fclose(data_out);
     return true;
   }
-  Predictor p(vocab);
+  Predictor p(vocab, options, threads);
   if (enable_preprocess) preprocessor::Pretrain(&p, dictionary);
 
   std::ofstream temp_out(temp_path, std::ios::out | std::ios::binary);
@@ -225,8 +237,8 @@ bool RunDecompression(bool enable_preprocess, const std::string& input_path,
   if (!data_out) return false;
 
   preprocessor::Decode(temp_in, data_out, temp_path, dictionary);
-  fseek(data_out, 0L, SEEK_END);
-  *output_bytes = ftell(data_out);
+  preprocessor::Seek(data_out, 0, SEEK_END);
+  *output_bytes = preprocessor::Tell(data_out);
   fclose(temp_in);
   fclose(data_out);
   remove(temp_path.c_str());
@@ -238,6 +250,20 @@ int main(int argc, char* argv[]) {
       (argv[1][1] != 'c' && argv[1][1] != 'd' && argv[1][1] != 's')) {
     return Help();
   }
+  unsigned char options = 0;
+  unsigned int threads = 1;
+  for (int i = 2; argv[1][i] != 0; ++i) {
+    if (argv[1][i] >= '1' && argv[1][i] <= '9' && argv[1][1] != 's') {
+      threads = argv[1][i] - '0';
+      continue;
+    }
+    if (argv[1][1] != 'c') return Help();
+    if (argv[1][i] == 'a') options |= Predictor::kDeferredLstmTraining;
+    else if (argv[1][i] == 'h') options |= Predictor::kHalfPrecisionLstm;
+    else if (argv[1][i] == 'g') options |= Predictor::kLinearByteMixer;
+    else if (argv[1][i] == 'q') options |= Predictor::kQuantizedMixer;
+    else return Help();
+  }
 
   clock_t start = clock();
 
@@ -249,6 +275,13 @@ int main(int argc, char* argv[]) {
     enable_preprocess = true;
     dictionary = fopen(argv[2], "rb");
     if (!dictionary) return Help();
+    preprocessor::Seek(dictionary, 0, SEEK_END);
+    if (preprocessor::Tell(dictionary) >
+        (long long)preprocessor::kMaxSegmentLength) {
+      fprintf(stderr, "dictionary is larger than 2 GB\n");
+      return Help();
+    }
+    preprocessor::Seek(dictionary, 0, SEEK_SET);
     input_path = argv[3];
     output_path = argv[4];
   }
@@ -264,13 +297,13 @@ int main(int argc, char* argv[]) {
       return Help();
     }
   } else if (argv[1][1] == 'c') {
-    if (!RunCompression(enable_preprocess, input_path, temp_path, output_path,
-        dictionary, &input_bytes, &output_bytes)) {
+    if (!RunCompression(enable_preprocess, options, threads, input_path,
+        temp_path, output_path, dictionary, &input_bytes, &output_bytes)) {
       return Help();
     }
   } else {
-    if (!RunDecompression(enable_preprocess, input_path, temp_path, output_path,
-        dictionary, &input_bytes, &output_bytes)) {
+    if (!RunDecompression(enable_preprocess, threads, input_path, temp_path,
+        output_path, dictionary, &input_bytes, &output_bytes)) {
       return Help();
     }
   }